@@ -37,6 +37,7 @@ Token::Token(const Token &token)
 		}
 	}
 	timestep = token.timestep;
+	base = token.base;
 }
 void Token::reset(const Token &token)
 {
@@ -67,6 +68,7 @@ void Token::reset(const Token &token)
 		}
 	}
 	timestep = token.timestep;
+	base = token.base;
 }
 
 //Agent
@@ -125,7 +127,7 @@ void Agent::Set(int loc, int col, int row, int id, unsigned int maxtime)
 bool Agent::TOTP(Token &token)
 {
 	//update agent current location
-	loc = path[token.timestep];
+	loc = path[token.timestep - token.base];
 
 	vector<bool> hold(col*row, false);
 	for (unsigned int i = 0; i < token.path.size(); i++)
@@ -161,7 +163,7 @@ bool Agent::TOTP(Token &token)
 		{
 			if (Move2EP(token))
 			{
-				for (int i = token.timestep; i < token.path[id].size(); i++) //agent move with package or waiting
+				for (int i = token.timestep - token.base; i < token.path[id].size(); i++) //agent move with package or waiting
 				{
 					token.path[id][i] = path[i];
 				}
@@ -179,23 +181,24 @@ bool Agent::TOTP(Token &token)
 
 	else //take this task
 	{
-		
+		vector<unsigned int> path_copy(path);
 		int arrive_start = AStar(loc, token.timestep, *task->start, token, id); 
-		if (arrive_start < 0)
-		{
-			system("PAUSE");
-		}
 
 		// try to find a path from start to goal
 		//if succeed, return the arriving timestep; otherwise, return -1
-		int arrive_goal = AStar(task->start->loc, arrive_start + task->start_time, *task->goal, token, id);
-		if (arrive_goal < 0) //find a path to goal
+		int arrive_goal = -1;
+		if (arrive_start >= 0)
+			arrive_goal = AStar(task->start->loc, arrive_start + task->start_time, *task->goal, token, id);
+		if (arrive_goal < 0) //the task does not fit in the planning window yet
 		{
-			system("PAUSE");
+			//keep the task in the token and wait, the agent retries once the window has moved on
+			path = path_copy;
+			finish_time = token.timestep + 1;
+			return true;
 		}
 		//update token path
 		//positive means deliver package or waiting at goal or home, negative means moving without package				
-		for (int i = token.timestep; i < token.path[id].size(); i++) //agent move with package or waiting
+		for (int i = token.timestep - token.base; i < token.path[id].size(); i++) //agent move with package or waiting
 		{
 			token.path[id][i] = path[i];
 		}
@@ -226,7 +229,7 @@ bool Agent::TPTR(Token &token)
 	Agent agent_copy(*this);
 
 	//update agent current location
-	loc = path[token.timestep];
+	loc = path[token.timestep - token.base];
 
 	//sort tasks by heuristic distances
 	boost::heap::fibonacci_heap< HeuristicNode, boost::heap::compare<CompareHeuristic> > heuristic;
@@ -283,7 +286,7 @@ bool Agent::TPTR(Token &token)
 				if (arrive_goal >= 0) //find a path to goal
 				{
 					//update token path			
-					for (int i = token.timestep; i < token.path[id].size(); i++)
+					for (int i = token.timestep - token.base; i < token.path[id].size(); i++)
 					{
 						token.path[id][i] = path[i];
 					}
@@ -352,7 +355,7 @@ bool Agent::TPTR(Token &token)
 			if ((*it)->goal->loc == loc) move = true;
 		}
 		//check whether agent can hold this location
-		for (unsigned int t = token.timestep; t < maxtime && !move; t++)
+		for (unsigned int t = token.timestep - token.base; t < maxtime && !move; t++)
 		{
 			for(unsigned int i = 0; i < token.agents.size() && !move; i++)
 				if (i != id && token.path[i][t] == loc) move = true;
@@ -362,7 +365,7 @@ bool Agent::TPTR(Token &token)
 			if (Move2EP(token)) //move to a nearest empty endpoint
 			{
 				//update token
-				for (int i = token.timestep; i < token.path[id].size(); i++)
+				for (int i = token.timestep - token.base; i < token.path[id].size(); i++)
 				{
 					token.path[id][i] = path[i];
 				}
@@ -380,10 +383,10 @@ bool Agent::TPTR(Token &token)
 		{
 			//cout << "Agent " << id << " waits at timestep " << token.timestep << endl;
 			//update path
-			for (int i = token.timestep + 1; i < maxtime; i++)
+			for (int i = token.timestep - token.base + 1; i < maxtime; i++)
 			{
-				path[i] = path[token.timestep];
-				token.path[id][i] = path[token.timestep];
+				path[i] = path[token.timestep - token.base];
+				token.path[id][i] = path[token.timestep - token.base];
 			}
 			finish_time = token.timestep + 1;
 			return true;
@@ -394,7 +397,7 @@ bool Agent::TPTR(Token &token)
 	{
 		if (Move2EP(token))//try to move to a nearest empty endpoint
 		{
-			for (int i = token.timestep; i < token.path[id].size(); i++) 
+			for (int i = token.timestep - token.base; i < token.path[id].size(); i++) 
 			{
 				token.path[id][i] = path[i];
 			}
@@ -410,10 +413,10 @@ bool Agent::TPTR(Token &token)
 	}
 }
 
-void Agent::updatePath(const Node &goal) //update path for agent
+void Agent::updatePath(const Node &goal, unsigned int base) //update path for agent
 {
 	//hold the goal
-	for (int i = goal.timestep + 1; i < path.size(); i++)
+	for (int i = goal.timestep - base + 1; i < path.size(); i++)
 	{
 		path[i] = goal.loc;
 	}
@@ -421,7 +424,7 @@ void Agent::updatePath(const Node &goal) //update path for agent
 	const Node* curr = &goal;
 	while (curr!=NULL)
 	{
-		path[curr->timestep] = curr->loc;
+		path[curr->timestep - base] = curr->loc;
 		curr = curr->parent;
 	}
 }
@@ -443,8 +446,8 @@ inline bool Agent::isConstrained(int curr_id, int next_id, int next_timestep, co
 		for (int ag = 0; ag < token.path.size(); ag++)
 		{
 			if (ag == id || ag==ag_hide) continue; //ignore its path and the original agent's path
-			else if (token.path[ag][next_timestep] == next_id) return true; //vertex collision
-			else if (token.path[ag][next_timestep - 1] == next_id && token.path[ag][next_timestep] == curr_id) return true; //edge collision
+			else if (token.path[ag][next_timestep - token.base] == next_id) return true; //vertex collision
+			else if (token.path[ag][next_timestep - token.base - 1] == next_id && token.path[ag][next_timestep - token.base] == curr_id) return true; //edge collision
 		}
 	
 	return false;
@@ -453,6 +456,7 @@ inline bool Agent::isConstrained(int curr_id, int next_id, int next_timestep, co
 //return final timestep if find a path, otherwise renturn -1
 int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal, const Token &token, int ag_hide)
 {
+	if (begin_time >= token.base + maxtime) return -1; //starts beyond the planning window
 	int goal_location = goal.loc;
 	heap_open_t open_list;
 	map<unsigned int, Node*> allNodes_table; //key = g_val*map_size+loc
@@ -478,7 +482,7 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal, const Toke
 		{
 			bool hold = true;
 			//test whether the goal can be held
-			for (unsigned int i = curr->timestep + 1; i < maxtime; i++)
+			for (unsigned int i = curr->timestep - token.base + 1; i < maxtime; i++)
 			{
 				for (unsigned int j = 0; j < token.agents.size(); j++)
 				{
@@ -491,7 +495,7 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal, const Toke
 			}
 			if (hold) //if it can be held, then return the path
 			{
-				updatePath(*curr);
+				updatePath(*curr, token.base);
 				int t = curr->timestep;
 				releaseClosedListNodes(allNodes_table);
 				return t;
@@ -500,7 +504,7 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal, const Toke
 		}
 
 		// check timestep
-		if (curr->timestep >= maxtime - 1) continue;
+		if (curr->timestep >= token.base + maxtime - 1) continue;
 
 
 		int next_id;
@@ -555,12 +559,12 @@ bool Agent::Move2EP(Token &token)
 	{
 		Node* v = Q.front();
 		Q.pop();
-		if (v->timestep >= maxtime - 1) continue; // time limit
+		if (v->timestep >= token.base + maxtime - 1) continue; // time limit
 		if (token.my_endpoints[v->loc]) // if v->loc is an endpoint
 		{
 			bool occupied = false;
 			// check whether v->loc can be held (no collision with other agents)
-			for (unsigned int t = v->timestep; t < maxtime && !occupied; t++)
+			for (unsigned int t = v->timestep - token.base; t < maxtime && !occupied; t++)
 			{
 				for (unsigned int ag = 0; ag < token.agents.size() && !occupied; ag++)
 				{
@@ -574,7 +578,7 @@ bool Agent::Move2EP(Token &token)
 			}
 			if (!occupied)// If this endpoint is empty, return path
 			{
-				updatePath(*v);
+				updatePath(*v, token.base);
 				finish_time = v->timestep;
 				//cout << "Agent " << id << " moves to endpoint " << v->loc << endl;
 				releaseClosedListNodes(allNodes_table);
@@ -32,7 +32,7 @@ public:
 	vector<unsigned int> path;
 	int loc;
 	int id;
-	unsigned int maxtime;
+	unsigned int maxtime; //length of path, the planning window
 	unsigned int finish_time; //time that the robot finishs the current task
 	Task *task;
 	int row;
@@ -40,7 +40,7 @@ public:
 	
 private:
 	int AStar(int start, int begin_time, const Endpoint &goal, const Token &token, int ag_hide); //return timestep or -1
-	void updatePath(const Node &goal);
+	void updatePath(const Node &goal, unsigned int base);
 	inline void releaseClosedListNodes(map<unsigned int, Node*> &allNodes_table);
 	inline bool isConstrained(int curr_id, int next_id, int next_timestep, const Token &token, int ag_hide);
 	bool Move2EP(Token &token); // move to empty endpoint
@@ -51,18 +51,19 @@ typedef enum { WAIT, TAKEN } TaskState;
 class Task
 {
 public:
-	Task(Endpoint *start, Endpoint *goal, int start_time, int goal_time)
-		:start(start), goal(goal), start_time(start_time), goal_time(goal_time), state(WAIT) {}
+	Task(const Endpoint *start, const Endpoint *goal, int start_time, int goal_time, unsigned int release_time)
+		:start(start), goal(goal), ag(NULL), start_time(start_time), goal_time(goal_time), release_time(release_time), state(WAIT) {}
 	~Task() {}
 
-	Endpoint *start;
-	Endpoint *goal;
+	const Endpoint *start;
+	const Endpoint *goal;
 
 	Agent* ag;
 	unsigned int ag_arrive_start;
 	unsigned int ag_arrive_goal;
 	int start_time; //min time agent need to spend at start point
 	int goal_time; //min time agent need to spend at goal point
+	unsigned int release_time; //timestep the task appears
 	TaskState state;
 
 };
@@ -70,7 +71,7 @@ public:
 class Token
 {
 public:
-	Token() { timestep = 0; }
+	Token() { timestep = 0; base = 0; }
 	Token(const Token &token);
 	~Token() {}
 	void reset(const Token &token);
@@ -80,6 +81,7 @@ public:
 	list<Task*> tasks;
 	vector<Agent*> agents;
 	
-	vector<vector<unsigned int> > path;//path[agent][time] = loc
+	vector<vector<unsigned int> > path;//path[agent][time - base] = loc
 	unsigned int timestep;
+	unsigned int base; //timestep stored at path[agent][0], only moves forward with a sliding horizon
 };
@@ -0,0 +1,95 @@
+#include "MapData.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+
+#include<boost/tokenizer.hpp> //use to read file
+
+
+bool MapData::Load(const string &fname)
+{
+	string line;
+	ifstream myfile(fname.c_str());
+	if (!myfile.is_open())
+	{
+		cerr << "Map file " << fname << " not found." << endl;
+		return false;
+	}
+	//read file
+	getline(myfile, line);
+	boost::char_separator<char> sep(",");
+	boost::tokenizer< boost::char_separator<char> > tok(line, sep);
+	boost::tokenizer< boost::char_separator<char> >::iterator beg = tok.begin();
+	row = atoi((*beg).c_str()) + 2; // read number of rows
+	beg++;
+	col = atoi((*beg).c_str()) + 2; // read number of cols
+
+	stringstream ss;
+	getline(myfile, line);
+	ss << line;
+	ss >> workpoint_num; //number of endpoints that may have tasks on. Other endpoints are home endpoints
+
+
+	ss.clear();
+	getline(myfile, line);
+	ss << line;
+	ss >> agent_num; //agent number
+
+	ss.clear();
+	getline(myfile, line);
+	ss << line;
+	ss >> maxtime; //max timestep
+	//resize all vectors
+	endpoints.resize(workpoint_num + agent_num);
+	my_map.resize(row*col);
+	my_endpoints.resize(row*col);
+
+	// read map
+	int ep = 0, ag = 0;
+	for (int i = 1; i<row - 1; i++)
+	{
+		getline(myfile, line);
+		for (int j = 1; j<col - 1; j++)
+		{
+			my_map[col*i + j] = (line[j - 1] != '@'); // not a block
+			my_endpoints[col*i + j] = (line[j - 1] == 'e') || (line[j - 1] == 'r'); // is an endpoint
+			if (line[j - 1] == 'e') //endpoint
+			{
+				endpoints[ep++].loc = i*col + j;
+                cout << "E[" << j << "," << i << "] ";
+			}
+			else if (line[j - 1] == 'r') //robot initial location, also regarded as home endpoint
+			{
+				endpoints[workpoint_num + ag].loc = i*col + j;
+				ag++;
+			}
+		}
+	}
+	myfile.close();
+
+	//set a bloack border of the map
+	for (int i = 0; i < row; i++)
+	{
+		my_map[i*col] = false;
+		my_map[i*col + col - 1] = false;
+		my_endpoints[i*col] = false;
+		my_endpoints[i*col + col - 1] = false;
+	}
+	for (int j = 1; j < col - 1; j++)
+	{
+		my_map[j] = false;
+		my_map[row*col - col + j] = false;
+		my_endpoints[j] = false;
+		my_endpoints[row*col - col + j] = false;
+	}
+
+	//initial heuristic matrix for each endpoint
+	for (unsigned int e = 0; e < endpoints.size(); e++)
+	{
+		endpoints[e].SetHVal(my_map, col);
+		endpoints[e].id = e;
+	}
+	return true;
+}
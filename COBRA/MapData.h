@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <string>
+
+#include "Endpoint.h"
+
+using namespace std;
+
+//map, endpoints and their heuristic matrices loaded from a map file
+//read-only after Load, so several Simulations (and threads) can share one copy
+class MapData
+{
+public:
+	MapData() : row(0), col(0), workpoint_num(0), agent_num(0), maxtime(0) {};
+	~MapData() {};
+	bool Load(const string &fname); //false if the file cannot be read, the map is then empty
+
+	int row, col;
+	int workpoint_num; //number of endpoints that may have tasks on. Other endpoints are home endpoints
+	int agent_num;
+	unsigned int maxtime;
+
+	vector<bool> my_map;
+	vector<bool> my_endpoints;
+	vector<Endpoint> endpoints; //endpoints[workpoint_num + ag] is the home (initial location) of agent ag
+};
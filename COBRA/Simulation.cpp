@@ -1,18 +1,38 @@
 
 #include <ctime>
+#include <chrono>
 
 #include "Simulation.h"
 #include <fstream>
 #include <iostream>
 
 
-Simulation::Simulation(string map_name, string task_name)
+Simulation::Simulation(string map_name, string task_name, bool stream)
+	:task_stream(NULL)
 {
 	computation_time = 0;
 	num_computations = 0;
+	time_limit = 0;
 	LoadMap(map_name);
-	LoadTask(task_name);
+	if (stream)
+		tasks_loaded = OpenTaskStream(task_name);
+	else
+		tasks_loaded = LoadTask(task_name);
+	reset();
+}
 
+Simulation::Simulation(shared_ptr<const MapData> map_data, string task_name, bool stream)
+	:map_data(map_data), task_stream(NULL)
+{
+	computation_time = 0;
+	num_computations = 0;
+	time_limit = 0;
+	SetMap();
+	if (stream)
+		tasks_loaded = OpenTaskStream(task_name);
+	else
+		tasks_loaded = LoadTask(task_name);
+	reset();
 }
 
 Simulation::~Simulation()
@@ -21,123 +41,138 @@ Simulation::~Simulation()
 
 void Simulation::LoadMap(string fname)
 {
-	string line;
-	ifstream myfile(fname.c_str());
-	if (!myfile.is_open())
-	{
-		cerr << "Map file not found." << endl;
-		system("PAUSE");
-		return;
-	}
-	//read file
-	getline(myfile, line);
-	boost::char_separator<char> sep(",");
-	boost::tokenizer< boost::char_separator<char> > tok(line, sep);
-	boost::tokenizer< boost::char_separator<char> >::iterator beg = tok.begin();
-	row = atoi((*beg).c_str()) + 2; // read number of rows
-	beg++;
-	col = atoi((*beg).c_str()) + 2; // read number of cols
-	
-	int agent_num;
-	stringstream ss;
-	getline(myfile, line);
-	ss << line;
-	ss >> workpoint_num; //number of endpoints that may have tasks on. Other endpoints are home endpoints
-
+	shared_ptr<MapData> data(new MapData());
+	if (!data->Load(fname)) exit(1); //nothing to simulate without the map
+	map_data = data;
+	SetMap();
+}
 
-	ss.clear();
-	getline(myfile, line);
-	ss << line;
-	ss >> agent_num; //agent number
+void Simulation::SetMap()
+{
+	row = map_data->row;
+	col = map_data->col;
+	workpoint_num = map_data->workpoint_num;
+	maxtime = map_data->maxtime;
+	sliding = false;
+	int agent_num = map_data->agent_num;
 
-	ss.clear();
-	getline(myfile, line);
-	ss << line;
-	ss >> maxtime; //max timestep
 	//resize all vectors
 	agents.resize(agent_num);
 	token.agents.resize(agent_num);
 	token.path.resize(agent_num);
-	endpoints.resize(workpoint_num + agent_num);
-	token.my_map.resize(row*col);
-	token.my_endpoints.resize(row*col);
+	token.my_map = map_data->my_map;
+	token.my_endpoints = map_data->my_endpoints;
 
-	// read map
-	int ep = 0, ag = 0;
-	for (int i = 1; i<row - 1; i++)
+	//robot initial locations are the home endpoints
+	for (int ag = 0; ag < agent_num; ag++)
 	{
-		getline(myfile, line);
-		for (int j = 1; j<col - 1; j++)
+		agents[ag].Set(map_data->endpoints[workpoint_num + ag].loc, col, row, ag, maxtime);
+		token.agents[ag] = &agents[ag];
+		token.path[ag].resize(maxtime);
+	}
+}
+
+// restore tasks, agents and token to the state before any run, keeping the map and heuristics
+void Simulation::reset()
+{
+	computation_time = 0;
+	num_computations = 0;
+
+	//agents stay at their home endpoints
+	for (unsigned int ag = 0; ag < agents.size(); ag++)
+	{
+		int loc = map_data->endpoints[workpoint_num + ag].loc;
+		agents[ag].loc = loc;
+		agents[ag].finish_time = 0;
+		agents[ag].task = NULL;
+		for (unsigned int k = 0; k < maxtime; k++)
 		{
-			token.my_map[col*i + j] = (line[j - 1] != '@'); // not a block
-			token.my_endpoints[col*i + j] = (line[j - 1] == 'e') || (line[j - 1] == 'r'); // is an endpoint
-			if (line[j - 1] == 'e') //endpoint
-			{
-				endpoints[ep++].loc = i*col + j;
-                cout << "E[" << j << "," << i << "] ";
-			}
-			else if (line[j - 1] == 'r') //robot initial location, also regarded as home endpoint
-			{
-				endpoints[workpoint_num + ag].loc = i*col + j;
-				agents[ag].Set(i*col + j, col, row, ag, maxtime);
-				token.agents[ag] = &agents[ag];
-				token.path[ag].resize(maxtime);
-				for (unsigned int k = 0; k < maxtime; k++)
-				{
-					token.path[ag][k] = i*col + j;
-				}
-				ag++;
-			}
+			agents[ag].path[k] = loc;
+			token.path[ag][k] = loc;
 		}
 	}
-	myfile.close();
 
-	//set a bloack border of the map
-	for (int i = 0; i < row; i++)
+	//no task is taken
+	for (unsigned int i = 0; i < tasks.size(); i++)
 	{
-		token.my_map[i*col] = false;
-		token.my_map[i*col + col - 1] = false;
-		token.my_endpoints[i*col] = false;
-		token.my_endpoints[i*col + col - 1] = false;
+		for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
+		{
+			it->state = WAIT;
+			it->ag = NULL;
+			it->ag_arrive_start = 0;
+			it->ag_arrive_goal = 0;
+		}
+	}
+
+	//token only holds the tasks released at timestep 0
+	//(streamed tasks already read are dropped, the stream cannot be rewound)
+	token.timestep = 0;
+	token.base = 0;
+	token.tasks.clear();
+	stream_tasks.clear();
+	retired_waiting_time = 0;
+	retired_last_finish = 0;
+	if (!tasks.empty())
+	{
+		for (list<Task>::iterator it = tasks[0].begin(); it != tasks[0].end(); it++)
+		{
+			token.tasks.push_back(&(*it));
+		}
 	}
-	for (int j = 1; j < col - 1; j++)
+	AddTasks(0, 0);
+}
+
+// agents are still at their home endpoints, so the window is filled with them
+void Simulation::SetHorizon(unsigned int horizon)
+{
+	sliding = true;
+	maxtime = horizon;
+	for (unsigned int ag = 0; ag < agents.size(); ag++)
 	{
-		token.my_map[j] = false;
-		token.my_map[row*col - col + j] = false;
-		token.my_endpoints[j] = false;
-		token.my_endpoints[row*col - col + j] = false;
+		agents[ag].maxtime = horizon;
+		agents[ag].path.resize(horizon, agents[ag].loc);
+		token.path[ag].resize(horizon, agents[ag].loc);
 	}
+}
 
-	//initial heuristic matrix for each endpoint
-	for (unsigned int e = 0; e < endpoints.size(); e++)
+// an agent takes a task at an endpoint (its home or where its last task or move ended),
+// so right after a slide the window must hold the way from the farthest endpoint to the start and then the task itself
+unsigned int Simulation::MinHorizon() const
+{
+	const vector<Endpoint> &endpoints = map_data->endpoints;
+	int reach = 0;
+	for (unsigned int i = 0; i < endpoints.size(); i++)
+	{
+		for (unsigned int j = 0; j < endpoints.size(); j++)
+			reach = reach > endpoints[i].h_val[endpoints[j].loc] ? reach : endpoints[i].h_val[endpoints[j].loc];
+	}
+	int task_len = reach; //streamed tasks are not known yet, any two endpoints may be start and goal
+	if (task_stream == NULL)
 	{
-		endpoints[e].SetHVal(token.my_map, col);
-		endpoints[e].id = e;
-		/*
-		cout << "Endpoint " << e << endl;
-		for (int i = 0; i < row; i++)
+		task_len = 0;
+		for (unsigned int i = 0; i < tasks.size(); i++)
 		{
-			for (int j = 0; j < col; j++)
+			for (list<Task>::const_iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
 			{
-				cout << endpoints[e].h_val[i*col + j] << " ";
+				int len = it->goal->h_val[it->start->loc] + it->start_time;
+				task_len = task_len > len ? task_len : len;
 			}
-			cout << endl;
 		}
-		*/
 	}
+	return reach + task_len + 1;
 }
 
-void Simulation::LoadTask(string fname)
+bool Simulation::LoadTask(string fname)
 {   
 	clock_t start_time = std::clock();
 
+	t_task = 0;
 	string line;
 	ifstream myfile(fname.c_str());
 	if (!myfile.is_open())
 	{
-		cerr << "Task file not found." << endl;
-		system("PAUSE");
-		return;
+		cerr << "Task file " << fname << " not found." << endl;
+		return false;
 	}
 	//read file
 	stringstream ss;
@@ -153,17 +188,10 @@ void Simulation::LoadTask(string fname)
 		ss.clear();
 		ss << line;
         ss >> t_task >> s >> g >> ts >> tg; //time + start + goal + time at start + time at goal
-		tasks[t_task].push_back(Task(&endpoints[s], &endpoints[g], ts, tg));
+		if (t_task >= (int)tasks.size()) tasks.resize(t_task + 1); //released after maxtime, only reached with a sliding horizon
+		tasks[t_task].push_back(Task(&map_data->endpoints[s], &map_data->endpoints[g], ts, tg, t_task));
 	}
 	myfile.close();
-
-	if (!tasks[0].empty())
-	{
-		for (list<Task>::iterator it = tasks[0].begin(); it != tasks[0].end(); it++)
-		{
-			token.tasks.push_back(&(*it));
-		}
-	}
 	
 	/*
 	for (int i = 0; i < maxtime; i++)
@@ -182,6 +210,121 @@ void Simulation::LoadTask(string fname)
 	clock_t end_time = std::clock();
 	double duration = double(end_time - start_time) / CLOCKS_PER_SEC;
 	cout << "Time taken by LoadTask :" << duration << "seconds" << endl;
+	return true;
+}
+
+bool Simulation::OpenTaskStream(const string &fname)
+{
+	t_task = 0;
+	if (fname == "-")
+	{
+		task_stream = &cin;
+		return true;
+	}
+	task_file.open(fname.c_str()); //a regular file or a named pipe
+	if (!task_file.is_open())
+	{
+		cerr << "Task stream not found." << endl;
+		return false;
+	}
+	task_stream = &task_file;
+	return true;
+}
+
+// each streamed line is: time start goal time_at_start time_at_goal, with non-decreasing time
+// lines with fewer fields (such as the task number of a task file) are skipped
+bool Simulation::PeekStreamTask()
+{
+	if (!stream_next.empty()) return true;
+	if (task_stream == NULL) return false;
+
+	string line;
+	while (getline(*task_stream, line)) // blocks until the producer writes a line or closes the stream
+	{
+		stringstream ss(line);
+		int t, s, g, ts, tg;
+		if (!(ss >> t >> s >> g >> ts >> tg)) continue;
+		if (t < 0 || s < 0 || g < 0 || s >= (int)map_data->endpoints.size() || g >= (int)map_data->endpoints.size())
+		{
+			cerr << "Invalid task: " << line << endl;
+			continue;
+		}
+		stream_next.push_back(Task(&map_data->endpoints[s], &map_data->endpoints[g], ts, tg, t));
+		return true;
+	}
+	task_stream = NULL; //end of the stream
+	return false;
+}
+
+void Simulation::AddTasks(unsigned int from, unsigned int to)
+{
+	for (unsigned int i = from + 1; i <= to && i < tasks.size(); i++)
+	{
+		for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
+		{
+			token.tasks.push_back(&(*it));
+		}
+	}
+	// streamed tasks released late are added now
+	while (PeekStreamTask() && stream_next.front().release_time <= to)
+	{
+		if ((int)stream_next.front().release_time > t_task) t_task = stream_next.front().release_time;
+		stream_tasks.splice(stream_tasks.end(), stream_next); //the task keeps its address
+		token.tasks.push_back(&stream_tasks.back());
+	}
+}
+
+bool Simulation::TasksRemain()
+{
+	if (!token.tasks.empty() || token.timestep <= t_task) return true;
+	return PeekStreamTask();
+}
+
+// a task is finished once its agent reaches the goal; it has left token.tasks by then
+void Simulation::RetireTasks()
+{
+	list<Task>::iterator it = stream_tasks.begin();
+	while (it != stream_tasks.end())
+	{
+		if (it->ag != NULL && it->ag_arrive_goal <= token.timestep)
+		{
+			retired_waiting_time += it->ag_arrive_goal - it->release_time;
+			retired_last_finish = retired_last_finish > it->ag_arrive_goal ? retired_last_finish : it->ag_arrive_goal;
+			it = stream_tasks.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
+
+// every agent has finish_time >= token.timestep, so no plan looks back before it
+// the window only moves once half of it has passed, to keep the shifting cost low
+void Simulation::Slide()
+{
+	if (!sliding) return;
+	unsigned int shift = token.timestep - token.base;
+	if (shift < maxtime / 2) return;
+	WritePathLog(token.timestep);
+	//a finish_time can pass the window by the goal_time of a task, every agent holds its last location by then
+	if (shift > maxtime) shift = maxtime;
+	for (unsigned int ag = 0; ag < agents.size(); ag++)
+	{
+		//agents hold their last location after the end of their paths
+		vector<unsigned int> &path = agents[ag].path;
+		copy(path.begin() + shift, path.end(), path.begin());
+		fill(path.end() - shift, path.end(), path.back());
+		vector<unsigned int> &token_path = token.path[ag];
+		copy(token_path.begin() + shift, token_path.end(), token_path.begin());
+		fill(token_path.end() - shift, token_path.end(), token_path.back());
+	}
+	token.base = token.timestep;
+}
+
+bool Simulation::OutOfTime(const chrono::steady_clock::time_point &run_start)
+{
+	return time_limit > 0 && chrono::duration<double>(chrono::steady_clock::now() - run_start).count() > time_limit;
 }
 
 void Simulation::run_TOTP()
@@ -189,8 +332,19 @@ void Simulation::run_TOTP()
 	clock_t start_time = std::clock();
 	cout << endl << "************TOTP************" << endl;
 
-	while (!token.tasks.empty() || token.timestep <= t_task)
+	chrono::steady_clock::time_point run_start = chrono::steady_clock::now();
+	while (TasksRemain())
 	{
+		if (OutOfTime(run_start))
+		{
+			cerr << "Time limit reached at timestep " << token.timestep << endl;
+			break;
+		}
+		if (task_stream != NULL && !sliding && token.timestep + 1 >= maxtime)
+		{
+			cerr << "Task stream stopped at maxtime " << maxtime << endl;
+			break;
+		}
 		// pick of  the first agent in the waiting line
 		Agent* ag = &agents[0];
 		for (int i = 1; i < agents.size(); i++)
@@ -205,19 +359,19 @@ void Simulation::run_TOTP()
 				ag = &agents[i];
 			}
 		}
-
-		//add new tasks
-		for (unsigned int i = token.timestep + 1; i <= ag->finish_time; i++)
+		if (!sliding && ag->finish_time >= maxtime)
 		{
-			if (tasks[i].empty()) continue;
-			for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
-			{
-				token.tasks.push_back(&(*it));
-			}
+			cerr << "Stopped at maxtime " << maxtime << endl;
+			break;
 		}
+
+		//add new tasks
+		AddTasks(token.timestep, ag->finish_time);
 		// update timestep
 		token.timestep = ag->finish_time;
-		ag->loc = ag->path[token.timestep];
+		Slide();
+		ag->loc = ag->path[token.timestep - token.base];
+		RetireTasks();
 
 		if (token.tasks.empty())//If no new tasks
 		{
@@ -240,7 +394,7 @@ void Simulation::run_TOTP()
 		if (!ag->TOTP(token))//not get a task
 		{
             cerr << "Not get a task." << endl;
-			system("PAUSE");
+			ag->finish_time = token.timestep + 1; //wait, the window may have moved on by the next try
 		}
 		computation_time += std::clock() - start;
 		/*if (!TestConstraints())
@@ -248,6 +402,14 @@ void Simulation::run_TOTP()
 			system("PAUSE");
 		}*/
 	}
+	if (path_log.is_open())
+	{
+		unsigned int end = token.timestep;
+		for (unsigned int ag = 0; ag < agents.size(); ag++)
+			end = end > agents[ag].finish_time ? end : agents[ag].finish_time;
+		WritePathLog(end + 1 < token.base + maxtime ? end + 1 : token.base + maxtime);
+		path_log.close();
+	}
 	clock_t end_time = std::clock();
 	double duration = double(end_time - start_time) / CLOCKS_PER_SEC;
 	cout << "Time taken by run_TOTP:" << duration << "seconds" << endl;
@@ -257,8 +419,19 @@ void Simulation::run_TPTR()
 	clock_t start_time = std::clock();
 	cout << endl << "************TPTR************" << endl;
 
-	while (!token.tasks.empty() || token.timestep <= t_task)
+	chrono::steady_clock::time_point run_start = chrono::steady_clock::now();
+	while (TasksRemain())
 	{
+		if (OutOfTime(run_start))
+		{
+			cerr << "Time limit reached at timestep " << token.timestep << endl;
+			break;
+		}
+		if (task_stream != NULL && !sliding && token.timestep + 1 >= maxtime)
+		{
+			cerr << "Task stream stopped at maxtime " << maxtime << endl;
+			break;
+		}
 		//pick off the first agent in the waiting line
 		Agent* ag = &agents[0];
 		for (int i = 1; i < agents.size(); i++)
@@ -273,18 +446,17 @@ void Simulation::run_TPTR()
 				ag = &agents[i];
 			}
 		}
-		//add new tasks to token
-		for (unsigned int i = token.timestep + 1; i <= ag->finish_time; i++)
+		if (!sliding && ag->finish_time >= maxtime)
 		{
-			if (tasks[i].empty()) continue;
-			for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
-			{
-				token.tasks.push_back(&(*it));
-			}
+			cerr << "Stopped at maxtime " << maxtime << endl;
+			break;
 		}
+		//add new tasks to token
+		AddTasks(token.timestep, ag->finish_time);
 		// update timestep
 		token.timestep = ag->finish_time;
-		ag->loc = ag->path[token.timestep];
+		Slide();
+		ag->loc = ag->path[token.timestep - token.base];
 
 		// delete finished tasks
 		list<Task*>::iterator it = token.tasks.begin();
@@ -301,6 +473,7 @@ void Simulation::run_TPTR()
 				it++;
 			}
 		}
+		RetireTasks();
 
 		//***************test*************************
 		/*unsigned int i = 0;
@@ -315,7 +488,7 @@ void Simulation::run_TPTR()
 		if (!ag->TPTR(token))//not get a task
 		{
             cerr << "Not get a task." << endl;
-			system("PAUSE");
+			ag->finish_time = token.timestep + 1; //wait, the window may have moved on by the next try
 
 		}
 		computation_time += std::clock() - start;
@@ -324,6 +497,14 @@ void Simulation::run_TPTR()
 			system("PAUSE");
 		}*/
 	} 
+	if (path_log.is_open())
+	{
+		unsigned int end = token.timestep;
+		for (unsigned int ag = 0; ag < agents.size(); ag++)
+			end = end > agents[ag].finish_time ? end : agents[ag].finish_time;
+		WritePathLog(end + 1 < token.base + maxtime ? end + 1 : token.base + maxtime);
+		path_log.close();
+	}
 	clock_t end_time = std::clock();
 	double duration = double(end_time - start_time) / CLOCKS_PER_SEC;
 	cout << "Time taken by run_TPTR:" << duration << "seconds" << endl;
@@ -375,6 +556,31 @@ void Simulation::run_TPTR()
     outputFile.close();
 }*/
 
+void Simulation::GetTaskStats(unsigned int &LastFinish, unsigned int &WaitingTime)
+{
+	WaitingTime = 0;
+	LastFinish = 0;
+	for (unsigned int i = 0; i < tasks.size(); i++)
+	{
+		for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
+		{
+			if (it->ag == NULL) continue; //not taken before the run stopped
+			//cout << "Agent " << it->ag->id << " delivers package from " << it->start->loc << " to " << it->goal->loc 
+			//	<< "	(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")" << endl;
+			WaitingTime += it->ag_arrive_goal - i;
+			LastFinish = LastFinish > it->ag_arrive_goal ? LastFinish : it->ag_arrive_goal;
+		}
+	}
+	//streamed tasks, finished ones are only kept as totals
+	WaitingTime += retired_waiting_time;
+	LastFinish = LastFinish > retired_last_finish ? LastFinish : retired_last_finish;
+	for (list<Task>::iterator it = stream_tasks.begin(); it != stream_tasks.end(); it++)
+	{
+		if (it->ag == NULL) continue;
+		WaitingTime += it->ag_arrive_goal - it->release_time;
+		LastFinish = LastFinish > it->ag_arrive_goal ? LastFinish : it->ag_arrive_goal;
+	}
+}
 
 void Simulation::ShowTask()
 {	
@@ -382,21 +588,7 @@ void Simulation::ShowTask()
 	unsigned int WaitingTime = 0;
 	unsigned int LastFinish = 0;
 	cout << endl << "TASK" << endl;
-	for (unsigned int i = 0; i < tasks.size(); i++)
-	{
-		if (tasks[i].size() > 0)
-		{
-			//cout << "Timestep " << i<<" :	";
-			for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
-			{
-				//cout << "Agent " << it->ag->id << " delivers package from " << it->start->loc << " to " << it->goal->loc 
-				//	<< "	(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")" << endl;
-				WaitingTime += it->ag_arrive_goal - i;
-				LastFinish = LastFinish > it->ag_arrive_goal ? LastFinish : it->ag_arrive_goal;
-			}
-			//cout << "	";
-		}
-	}
+	GetTaskStats(LastFinish, WaitingTime);
 	cout << endl << "Finishing Timestep:	" << LastFinish << endl;
 	cout << "Sum of Task Waiting Time:	" << WaitingTime << endl;
 	clock_t end_time = std::clock();
@@ -410,26 +602,9 @@ void Simulation::SaveTask(const string &fname, const string &instance_name)
 	// write output file
 	std::ofstream fout(fname, ios::app);
 	if (!fout) return;
-	//fout << mPanel->agents.size() << std::endl;
 	unsigned int WaitingTime = 0;
 	unsigned int LastFinish = 0;
-	for (unsigned int i = 0; i < tasks.size(); i++)
-	{
-		if (tasks[i].size() > 0)
-		{
-			//fout << "Timestep " << i << " :	";
-			for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
-			{
-				//fout << "Agent " << it->ag->id << " delivers package from " << it->start->loc << " to " << it->goal->loc
-				//	<< "	(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")" << endl;
-				WaitingTime += it->ag_arrive_goal - i;
-				LastFinish = LastFinish > it->ag_arrive_goal ? LastFinish : it->ag_arrive_goal;
-			}
-			//cout << "	";
-		}
-	}
-	//fout << endl << "Finishing Timestep:	" << LastFinish << endl;
-	//fout << "Sum of Task Waiting Time:	" << WaitingTime << endl;
+	GetTaskStats(LastFinish, WaitingTime);
 	fout << instance_name << " " << LastFinish << " " << WaitingTime << " " << computation_time / (double)LastFinish << endl;
 	fout.close();
 	clock_t end_time = std::clock();
@@ -443,8 +618,14 @@ void Simulation::SaveThroughput(const string &fname)
 	std::ofstream fout(fname + ".throughput");
 	if (!fout) return;
 	//fout << mPanel->agents.size() << std::endl;
-	vector<int> thpts(5000, 0);
-	vector<int> inpts(5000, 0);
+	//each task counts for 100 timesteps after its release and its delivery,
+	//at least 5000 rows, more if tasks are released or delivered later
+	unsigned int rows = max(5000u, (unsigned int)tasks.size() + 100);
+	for (unsigned int i = 0; i < tasks.size(); i++)
+		for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
+			if (it->ag != NULL) rows = max(rows, it->ag_arrive_goal + 100);
+	vector<int> thpts(rows, 0);
+	vector<int> inpts(rows, 0);
 
 	unsigned int WaitingTime = 0;
 	unsigned int LastFinish = 0;
@@ -455,6 +636,7 @@ void Simulation::SaveThroughput(const string &fname)
 			//fout << "Timestep " << i << " :	";
 			for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end(); it++)
 			{
+				if (it->ag == NULL) continue; //not taken before the run stopped
 				//fout << "Agent " << it->ag->id << " delivers package from " << it->start->loc << " to " << it->goal->loc
 				//	<< "	(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")" << endl;
 				for (int time = 0; time < 100; time++) {
@@ -479,6 +661,28 @@ void Simulation::SaveThroughput(const string &fname)
 	double duration = double(end_time - start_time) / CLOCKS_PER_SEC;
 	cout << "Time taken by SaveThroughput :" << duration << "seconds" << endl;
 }
+void Simulation::OpenPathLog(const string &fname)
+{
+	path_log.open(fname.c_str());
+	if (!path_log) cerr << "Cannot open " << fname << endl;
+}
+
+// one line per timestep: t x0 y0 x1 y1 ...
+void Simulation::WritePathLog(unsigned int end)
+{
+	if (!path_log.is_open()) return;
+	for (unsigned int t = token.base; t < end; t++)
+	{
+		path_log << t;
+		unsigned int k = t - token.base < maxtime ? t - token.base : maxtime - 1; //agents hold their last location after the window
+		for (unsigned int ag = 0; ag < token.path.size(); ag++)
+		{
+			path_log << "	" << token.path[ag][k] % col - 1 << "	" << token.path[ag][k] / col - 1;
+		}
+		path_log << endl;
+	}
+}
+
 void Simulation::SavePath(const string &fname)
 {	
 	clock_t start_time = std::clock();
@@ -508,19 +712,19 @@ bool Simulation::TestConstraints()// test vertex collision and edge collision
 	{
 		for (unsigned int i = ag + 1; i < agents.size(); i++)
 		{
-			for (unsigned int j = token.timestep + 1; j < maxtime; j++)
+			for (unsigned int j = token.timestep - token.base + 1; j < maxtime; j++)
 			{
 				if (agents[ag].path[j] == agents[i].path[j])
 				{
 					cout << "Agent " << ag << " and " << i << " collide at location "
-						<< agents[ag].path[j] << " at time " << j << endl;
+						<< agents[ag].path[j] << " at time " << j + token.base << endl;
 					return false;
 				}
 				else if (token.timestep > 0 && agents[ag].path[j] == agents[i].path[j - 1]
 					&& agents[ag].path[j - 1] == agents[i].path[j])
 				{
 					cout << "Agent " << ag << " and " << i << " collide at edge "
-						<< agents[ag].path[j - 1] << "-" << agents[ag].path[j] << " at time " << j << endl;
+						<< agents[ag].path[j - 1] << "-" << agents[ag].path[j] << " at time " << j + token.base << endl;
 					return false;
 				}
 			}
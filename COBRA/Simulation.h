@@ -11,10 +11,12 @@
 #include <climits>
 //#include <float.h>
 
-#include<boost/tokenizer.hpp> //use to read file
+#include <memory>
+#include <chrono>
 
 #include "Endpoint.h"
 #include "Agent.h"
+#include "MapData.h"
 using namespace std;
 
 
@@ -22,41 +24,74 @@ class Simulation
 {
 public:
 
-	Simulation(string map_name, string task_name);
+	//if stream is true, task_name is a stream ("-" for stdin, or a named pipe) read while the simulation runs
+	Simulation(string map_name, string task_name, bool stream = false);
+	Simulation(shared_ptr<const MapData> map_data, string task_name, bool stream = false); //share a map already loaded
 	~Simulation();
 	
 
 	//run
 	void run_TOTP();
 	void run_TPTR();
+	void reset(); //back to timestep 0 without reloading the map or tasks
+	//plan in a window of horizon timesteps that slides forward, so runs are not bounded by maxtime
+	void SetHorizon(unsigned int horizon);
+	unsigned int MinHorizon() const; //shortest horizon in which any task fits
 
 	//save
 	void ShowTask();
 	//void ShowTask(std::ostream& out = std::cout); // Modified to accept output stream
 	void SavePath(const string &fname);
+	void OpenPathLog(const string &fname); //with a sliding horizon, write each timestep once it leaves the window
 	void SaveTask(const string &fname, const string &instance_name);
 	void SaveThroughput(const string &fname);
+	void GetTaskStats(unsigned int &LastFinish, unsigned int &WaitingTime);
+	unsigned int GetAgentNum() const { return agents.size(); }
+	bool TasksLoaded() const { return tasks_loaded; } //false if the task file or stream could not be opened
 
 	double computation_time;
 	int num_computations;
+	double time_limit; //wall-clock seconds for one run, 0 means no limit
 
 private:
 	// initialize
 	void LoadMap(string fname);
-	void LoadTask(string fname);
+	void SetMap(); //copy map_data into the token and place agents at their home endpoints
+	bool LoadTask(string fname); //false if the file cannot be read, there are no tasks then
+	bool OpenTaskStream(const string &fname);
+	// tasks
+	void AddTasks(unsigned int from, unsigned int to); //add tasks released in (from, to] to the token
+	bool PeekStreamTask(); //read the next streamed task, false at the end of the stream
+	bool TasksRemain();
+	void RetireTasks(); //fold finished streamed tasks into the stats and free them
+	bool OutOfTime(const chrono::steady_clock::time_point &run_start);
+	// sliding horizon
+	void Slide(); //move the window to token.timestep
+	void WritePathLog(unsigned int end); //write timesteps [token.base, end) of the window
 	// test 
 	bool TestConstraints();
 private:
 	int row, col;
 	Token token;
 	vector<list<Task>> tasks;
-	vector<Endpoint> endpoints;
+	shared_ptr<const MapData> map_data; //map and endpoint heuristics, never modified by the simulation
 	vector<Agent> agents;
 
-	unsigned int maxtime;
+	unsigned int maxtime; //length of the path window
+	bool sliding; //maxtime is a sliding horizon instead of the last timestep
+	ofstream path_log;
 	
 	int workpoint_num; //number of endpoints that may have tasks on. Other endpoints are home endpoints
 	int t_task;//timestep that last task appears
+	bool tasks_loaded;
+
+	//streaming mode
+	istream *task_stream; //NULL when tasks are loaded from a file
+	ifstream task_file;
+	list<Task> stream_next; //next streamed task, not released yet
+	list<Task> stream_tasks; //released streamed tasks that are not finished
+	unsigned int retired_waiting_time;
+	unsigned int retired_last_finish;
 
 	//static void batch_run(const string& batch_input_file); // Add this declaration
     //void ShowTask(std::ostream& out = std::cout); // Modified to accept output stream
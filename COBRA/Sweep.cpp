@@ -0,0 +1,172 @@
+#include "Sweep.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+
+#include "Simulation.h"
+
+
+Sweep::Sweep(unsigned int num_threads, double time_limit)
+	:num_threads(num_threads), time_limit(time_limit), next_job(0)
+{
+	if (this->num_threads == 0)
+		this->num_threads = thread::hardware_concurrency();
+	if (this->num_threads == 0)
+		this->num_threads = 1;
+}
+
+bool Sweep::LoadJobs(const string &fname)
+{
+	string line;
+	ifstream myfile(fname.c_str());
+	if (!myfile.is_open())
+	{
+		cerr << "Sweep file not found." << endl;
+		return false;
+	}
+	while (getline(myfile, line))
+	{
+		stringstream ss(line);
+		SweepJob job;
+		if (!(ss >> job.map_name) || job.map_name[0] == '#') continue; //empty line or comment
+		if (!(ss >> job.task_name))
+		{
+			cerr << "Sweep line without a task file: " << line << endl;
+			return false;
+		}
+		string algorithm;
+		while (ss >> algorithm)
+		{
+			if (algorithm != "TOTP" && algorithm != "TPTR")
+			{
+				cerr << "Unknown algorithm " << algorithm << " in sweep line: " << line << endl;
+				return false;
+			}
+			job.algorithms.push_back(algorithm);
+		}
+		if (job.algorithms.empty()) //run both by default
+		{
+			job.algorithms.push_back("TOTP");
+			job.algorithms.push_back("TPTR");
+		}
+		jobs.push_back(job);
+		map_jobs[job.map_name]++;
+	}
+	myfile.close();
+	return true;
+}
+
+bool Sweep::Run(const string &csv_name)
+{
+	csv.open(csv_name.c_str());
+	if (!csv) return false;
+	csv << "map,task,algorithm,agents,finishing_timestep,waiting_time,num_computations,runtime" << endl;
+
+	unsigned int workers = num_threads < jobs.size() ? num_threads : jobs.size();
+	vector<thread> pool;
+	for (unsigned int i = 0; i < workers; i++)
+	{
+		pool.push_back(thread(&Sweep::Worker, this));
+	}
+	for (unsigned int i = 0; i < pool.size(); i++)
+	{
+		pool[i].join();
+	}
+	csv.close();
+	return true;
+}
+
+void Sweep::Worker()
+{
+	while (true)
+	{
+		unsigned int id;
+		{
+			lock_guard<mutex> lock(job_mutex);
+			if (next_job >= jobs.size()) return;
+			id = next_job++;
+		}
+		const SweepJob &job = jobs[id];
+		shared_ptr<const MapData> map_data = GetMap(job.map_name);
+		if (!map_data)
+		{
+			SkipJob(job);
+		}
+		else
+		{
+			//the simulation is released before the next job is taken
+			Simulation simu(map_data, job.task_name);
+			simu.time_limit = time_limit;
+			if (!simu.TasksLoaded())
+				SkipJob(job);
+			else for (unsigned int i = 0; i < job.algorithms.size(); i++)
+			{
+				if (i > 0) simu.reset();
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				if (job.algorithms[i] == "TOTP")
+					simu.run_TOTP();
+				else
+					simu.run_TPTR();
+				double runtime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+				unsigned int LastFinish = 0, WaitingTime = 0;
+				simu.GetTaskStats(LastFinish, WaitingTime);
+				lock_guard<mutex> lock(csv_mutex);
+				csv << job.map_name << "," << job.task_name << "," << job.algorithms[i] << "," << simu.GetAgentNum() << ","
+					<< LastFinish << "," << WaitingTime << "," << simu.num_computations << "," << runtime << endl;
+			}
+		}
+		ReleaseMap(job.map_name);
+	}
+}
+
+//the job still gets its rows, with empty results
+void Sweep::SkipJob(const SweepJob &job)
+{
+	cerr << "Sweep job skipped: " << job.map_name << " " << job.task_name << endl;
+	lock_guard<mutex> lock(csv_mutex);
+	for (unsigned int i = 0; i < job.algorithms.size(); i++)
+		csv << job.map_name << "," << job.task_name << "," << job.algorithms[i] << ",,,,," << endl;
+}
+
+//load a map the first time a job asks for it, then share the same copy
+//the map is loaded outside map_mutex, so workers on other maps are not blocked;
+//workers on the same map wait for its future instead
+//returns NULL if the map cannot be loaded, a failed map is remembered until its jobs finish
+shared_ptr<const MapData> Sweep::GetMap(const string &fname)
+{
+	promise<shared_ptr<const MapData> > loader;
+	MapFuture data;
+	bool first = false;
+	{
+		lock_guard<mutex> lock(map_mutex);
+		map<string, MapFuture>::iterator it = maps.find(fname);
+		if (it != maps.end())
+			data = it->second;
+		else
+		{
+			data = loader.get_future().share();
+			maps[fname] = data;
+			first = true;
+		}
+	}
+	if (first)
+	{
+		shared_ptr<MapData> loaded(new MapData());
+		if (loaded->Load(fname))
+			loader.set_value(loaded);
+		else
+			loader.set_value(shared_ptr<const MapData>());
+	}
+	return data.get();
+}
+
+//drop a map from the store once no remaining job needs it
+void Sweep::ReleaseMap(const string &fname)
+{
+	lock_guard<mutex> lock(map_mutex);
+	if (--map_jobs[fname] == 0)
+		maps.erase(fname);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <list>
+#include <map>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <future>
+
+#include "MapData.h"
+
+using namespace std;
+
+//one line of a sweep file: <map file> <task file> [TOTP] [TPTR]
+//all algorithms of a line run back-to-back on the same Simulation
+struct SweepJob
+{
+	string map_name;
+	string task_name;
+	vector<string> algorithms;
+};
+
+//runs independent Simulations on a pool of threads
+//maps (and their heuristic matrices) are loaded once and shared read-only by all workers,
+//each worker holds one Simulation at a time and every result is written to the CSV as soon as it is done
+class Sweep
+{
+public:
+	Sweep(unsigned int num_threads, double time_limit = 0);
+	~Sweep() {};
+
+	bool LoadJobs(const string &fname);
+	bool Run(const string &csv_name);
+
+private:
+	void Worker();
+	void SkipJob(const SweepJob &job); //write the rows of a job that cannot run
+	shared_ptr<const MapData> GetMap(const string &fname);
+	void ReleaseMap(const string &fname);
+
+	unsigned int num_threads;
+	double time_limit; //for each run, 0 means no limit
+	vector<SweepJob> jobs;
+	unsigned int next_job;
+	mutex job_mutex;
+
+	typedef shared_future<shared_ptr<const MapData> > MapFuture; //ready once the map is loaded, NULL if it failed
+	map<string, MapFuture> maps; //maps still needed by some job
+	map<string, int> map_jobs; //number of unfinished jobs on each map
+	mutex map_mutex;
+
+	ofstream csv;
+	mutex csv_mutex;
+};
@@ -1,22 +1,138 @@
 #include "Simulation.h"
+#include "Sweep.h"
+
+#include <boost/program_options.hpp>
 
 int main(int argc, char** argv)
 {
-    Simulation simu1(argv[1], argv[2]);
-    simu1.run_TOTP();
-//    simu1.SaveThroughput((string)argv[2] + "_tp_throughput");
-//    simu1.SaveTask((string)argv[2] + "_tp_out", argv[2]);
-    simu1.SavePath((string)argv[2] + "_tp_path");
-
-	Simulation simu2(argv[1], argv[2]);
-	simu2.run_TPTR();
-//    simu2.SaveThroughput((string)argv[2] + "_tptr_throughput");
-//    simu2.SaveTask((string)argv[2] + "_tptr_out", argv[2]);
-    simu2.SavePath((string)argv[2] + "_tptr_path");
-
-//    simu1.ShowTask();
-	simu2.ShowTask();
-    return 0;
+	namespace po = boost::program_options;
+	po::options_description desc("Allowed options");
+	desc.add_options()
+		("help,h", "produce help message")
+		("map,m", po::value<string>(), "input file for map")
+		("task,t", po::value<string>(), "input file for tasks")
+		("algorithm,a", po::value<vector<string> >()->multitoken(), "algorithms to run: TOTP TPTR (default both)")
+		("output,o", po::value<vector<string> >()->multitoken(), "outputs to write: path task throughput none (default path)")
+		("stream", "read tasks from TaskFile (\"-\" for stdin, or a named pipe) while the simulation runs")
+		("horizon,H", po::value<unsigned int>()->default_value(0), "sliding planning window in timesteps, 0 to stop at maxtime of the map")
+		("time-limit,l", po::value<double>()->default_value(0), "wall-clock seconds for each run, 0 for no limit")
+		("sweep,s", po::value<string>(), "sweep file, one <map> <task> [algorithms] per line")
+		("csv,c", po::value<string>()->default_value("sweep.csv"), "output file for sweep results")
+		("threads,j", po::value<unsigned int>()->default_value(0), "sweep threads, 0 for all cores")
+	;
+	po::positional_options_description pos;
+	pos.add("map", 1).add("task", 1);
+
+	po::variables_map vm;
+	try
+	{
+		po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+		po::notify(vm);
+	}
+	catch (const po::error &e)
+	{
+		cerr << e.what() << endl << desc << endl;
+		return 1;
+	}
+	if (vm.count("help"))
+	{
+		cout << desc << endl;
+		return 0;
+	}
+
+	if (vm.count("sweep"))
+	{
+		Sweep sweep(vm["threads"].as<unsigned int>(), vm["time-limit"].as<double>());
+		if (!sweep.LoadJobs(vm["sweep"].as<string>()) || !sweep.Run(vm["csv"].as<string>()))
+			return 1;
+		return 0;
+	}
+
+	if (!vm.count("map") || !vm.count("task"))
+	{
+		cerr << "Usage: " << argv[0] << " MapFile TaskFile [options]" << endl << desc << endl;
+		return 1;
+	}
+	string map_name = vm["map"].as<string>();
+	string task_name = vm["task"].as<string>();
+
+	vector<string> algorithms;
+	if (vm.count("algorithm"))
+		algorithms = vm["algorithm"].as<vector<string> >();
+	else
+	{
+		algorithms.push_back("TOTP");
+		algorithms.push_back("TPTR");
+	}
+	bool save_path = !vm.count("output"), save_task = false, save_throughput = false;
+	if (vm.count("output"))
+	{
+		vector<string> outputs = vm["output"].as<vector<string> >();
+		for (unsigned int i = 0; i < outputs.size(); i++)
+		{
+			if (outputs[i] == "path") save_path = true;
+			else if (outputs[i] == "task") save_task = true;
+			else if (outputs[i] == "throughput") save_throughput = true;
+			else if (outputs[i] != "none")
+			{
+				cerr << "Unknown output " << outputs[i] << endl;
+				return 1;
+			}
+		}
+	}
+
+	bool stream = vm.count("stream") > 0;
+	if (stream)
+	{
+		//a stream is consumed by the first run and per-timestep counts of old tasks are not kept
+		if (algorithms.size() != 1 || save_throughput)
+		{
+			cerr << "--stream needs exactly one algorithm and no throughput output" << endl;
+			return 1;
+		}
+		if (task_name == "-") task_name = "stream";
+	}
+	unsigned int horizon = vm["horizon"].as<unsigned int>();
+
+	//all algorithms run on the same loaded instance
+	Simulation simu(map_name, vm["task"].as<string>(), stream);
+	if (!simu.TasksLoaded()) return 1;
+	simu.time_limit = vm["time-limit"].as<double>();
+	if (horizon > 0)
+	{
+		//a shorter window could never hold the longest task after the way to its start
+		if (horizon < simu.MinHorizon())
+		{
+			cerr << "--horizon " << horizon << " is too short for the tasks on this map, it must be at least " << simu.MinHorizon() << endl;
+			return 1;
+		}
+		simu.SetHorizon(horizon);
+	}
+	for (unsigned int i = 0; i < algorithms.size(); i++)
+	{
+		string suffix;
+		if (algorithms[i] == "TOTP") suffix = "_tp";
+		else if (algorithms[i] == "TPTR") suffix = "_tptr";
+		else
+		{
+			cerr << "Unknown algorithm " << algorithms[i] << endl;
+			return 1;
+		}
+
+		if (i > 0) simu.reset();
+		//the window only holds recent timesteps, so the path is written while the run goes
+		if (horizon > 0 && save_path) simu.OpenPathLog(task_name + suffix + "_path");
+		if (algorithms[i] == "TOTP")
+			simu.run_TOTP();
+		else
+			simu.run_TPTR();
+
+		if (save_throughput) simu.SaveThroughput(task_name + suffix + "_throughput");
+		if (save_task) simu.SaveTask(task_name + suffix + "_out", task_name);
+		if (save_path && horizon == 0) simu.SavePath(task_name + suffix + "_path");
+		simu.ShowTask();
+	}
+	return 0;
 }
 
 /*#include <iostream>
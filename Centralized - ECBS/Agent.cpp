@@ -21,7 +21,7 @@ struct CompareHeuristic
 
 
 Agent::Agent(int loc, int col, int row, int id, int maxtime)
-	:loc(loc), col(col), row(row), id(id), timestep(1), maxtime(maxtime),task(NULL), delivering(false)
+	:loc(loc), col(col), row(row), id(id), timestep(1), maxtime(maxtime),task(NULL), delivering(false), plan_time(0)
 { 
 	for (int i = 0; i < maxtime; i++)
 	{
@@ -40,6 +40,7 @@ Agent::Agent(const Agent &ag)
 	row = ag.row;
 	col = col;
 	delivering = ag.delivering;
+	plan_time = ag.plan_time;
 }
 Agent::~Agent()
 {
@@ -59,6 +60,7 @@ void Agent::reset(const Agent &ag)
 	row = ag.row;
 	col = ag.col;
 	delivering = ag.delivering;
+	plan_time = ag.plan_time;
 }
 
 void Agent::Set(int loc, int col, int row, int id, int maxtime)
@@ -70,6 +72,7 @@ void Agent::Set(int loc, int col, int row, int id, int maxtime)
 	this->timestep = 0;
 	this->task = NULL;
 	this->delivering = false;
+	this->plan_time = 0;
 	this->maxtime = maxtime;
 	for (int i = 0; i < maxtime; i++)
 	{
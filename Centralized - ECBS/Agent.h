@@ -32,6 +32,7 @@ public:
 	unsigned int maxtime;
 	unsigned int timestep;//current timestep
 	unsigned int arrive_time;
+	unsigned int plan_time; //timestep of the agent's last path finding
 	Task *task;
 	int row;
 	int col;
@@ -44,7 +45,7 @@ class Task
 {
 public:
 	Task(Endpoint *start, Endpoint *goal, int start_time, int goal_time)
-		:start(start), goal(goal), start_time(start_time), goal_time(goal_time), delivering(false) {}
+		:start(start), goal(goal), ag(NULL), start_time(start_time), goal_time(goal_time), delivering(false) {}
 	~Task() {}
 
 	Endpoint *start;
@@ -1,9 +1,31 @@
 #include "Simulation.h"
 
 #include <ctime>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 
 Simulation::Simulation(string map_name, string task_name)
 {
+	time_limit = 0;
+	parallel_children = false;
+	plan_budget = 0;
+	window = 0;
+	replan_period = 0;
+	warm_start = false;
+	assign_candidates = -1;
+	assign_threads = 1;
+	auction_assign = false;
+	batch_planning = false;
+	skip_idle = false;
+	plan_failed = false;
+	verify_period = 1;
+	verify_incremental = false;
+	verified_paths = NULL;
+	event_driven = false;
+	prioritized_first = false;
+	latency_target = 0;
+	max_focal_w = 2;
 
 	LoadMap(map_name);
 	LoadTask(task_name);
@@ -11,6 +33,7 @@ Simulation::Simulation(string map_name, string task_name)
 }
 Simulation::~Simulation()
 {
+	delete verified_paths;
 }
 
 void Simulation::LoadMap(string fname)
@@ -175,62 +198,174 @@ void Simulation::AssignTasks(vector<Agent*> &agents, const vector<vector<int> >
 	
 	//compute cost matrix
 	//cout << "Cost matrix:" << endl;
-	dlib::matrix<int> cost(starts.size(), starts.size());
-	for (unsigned int i = 0; i < starts.size(); i++)
+	ConstraintTable cons_paths_table(my_map.size()); //paths of DELIVER agents, hashed once for all the searches below
+	for (unsigned int i = 0; i < cons_paths.size(); i++)
+		cons_paths_table.addPath(cons_paths[i], timestep);
+	//path lengths from each agent to each start: the BFS distance (h_val) + 1, refined by a search (that respects
+	//the paths of DELIVER agents) for the assign_candidates nearest starts of each agent (all of them if negative)
+	//rows are independent, so they are filled by assign_threads threads (each search has its own SingleAgentECBS,
+	//cons_paths_table is only read) and the result does not depend on the threads.
+	//The searches ignore the other non-DELIVER agents, so they run without a reservation table
+	vector<vector<int> > path_len(agents.size(), vector<int>(starts.size(), 0));
+	vector<int> num_failures(agents.size(), 0);
+	vector<vector<unsigned int> > candidates(agents.size()); //starts whose path lengths were searched
+	auto fill_row = [&](unsigned int i)
 	{
-		if (i >= agents.size())
+		vector<pair<int, unsigned int> > nearest; //(distance, start)
+		for (unsigned int j = 0; j < starts.size(); j++)
 		{
-			for (unsigned int j = 0; j < starts.size(); j++)
+			path_len[i][j] = starts[j]->h_val[agents[i]->loc] + 1;
+			if (starts[j]->h_val[agents[i]->loc] >= 0)
+				nearest.push_back(make_pair(starts[j]->h_val[agents[i]->loc], j));
+		}
+		if (assign_candidates >= 0 && nearest.size() > (unsigned int)assign_candidates)
+		{
+			partial_sort(nearest.begin(), nearest.begin() + assign_candidates, nearest.end());
+			nearest.resize(assign_candidates);
+		}
+		for (unsigned int k = 0; k < nearest.size(); k++)
+		{
+			unsigned int j = nearest[k].second;
+			SingleAgentECBS single(&cons_paths_table, starts[j]->h_val, my_map, i, agents[i]->loc, starts[j]->loc, col, timestep, maxtime);
+			if (single.findPath(1, NULL, NULL, maxtime, i) == false)
+				num_failures[i]++;
+			path_len[i][j] = single.path.size();
+			candidates[i].push_back(j);
+		}
+	};
+	if (assign_threads <= 1 || agents.size() <= 1)
+	{
+		for (unsigned int i = 0; i < agents.size(); i++)
+			fill_row(i);
+	}
+	else
+	{
+		atomic<unsigned int> next_row(0);
+		vector<thread> workers;
+		for (unsigned int w = 0; w < assign_threads && w < agents.size(); w++)
+		{
+			workers.push_back(thread([&]()
 			{
-				cost(i, j) = 0;
-			}
+				for (unsigned int i = next_row++; i < agents.size(); i = next_row++)
+					fill_row(i);
+			}));
 		}
-		else
+		for (unsigned int w = 0; w < workers.size(); w++)
+			workers[w].join();
+	}
+	for (unsigned int i = 0; i < agents.size(); i++)
+		for (int k = 0; k < num_failures[i]; k++)
+			cout << "NO SOLUTION EXISTS";
+
+	vector<long> assignment;
+	bool assigned = false;
+	if (auction_assign)
+	{
+		//sparse auction over the candidate edges of each agent, warm-started from the prices of the previous timestep.
+		//Edges also go from each task to its assign_candidates nearest agents (so far tasks are not starved) and from
+		//each agent to the endpoint added for it. Benefits rank assignments as the cost matrix below does (more tasks,
+		//then shorter task paths, then shorter endpoint paths): a step of task path is worth task_weight, more than the
+		//endpoint paths of all agents together. The weights do not change with the number of free agents and starts,
+		//so that prices stay comparable between timesteps
+		if (assign_candidates >= 0)
 		{
 			for (unsigned int j = 0; j < tasks.size(); j++)
 			{
-				if (starts[j]->h_val[agents[i]->loc] == -1)
+				vector<pair<int, unsigned int> > nearest; //(distance, agent)
+				for (unsigned int i = 0; i < agents.size(); i++)
+					if (starts[j]->h_val[agents[i]->loc] >= 0)
+						nearest.push_back(make_pair(starts[j]->h_val[agents[i]->loc], i));
+				if (nearest.size() > (unsigned int)assign_candidates)
 				{
-					cost(i, j) = 0;
-					system("PAUSE");
+					partial_sort(nearest.begin(), nearest.begin() + assign_candidates, nearest.end());
+					nearest.resize(assign_candidates);
 				}
-				else
+				for (unsigned int k = 0; k < nearest.size(); k++)
 				{
-					bool* res_table = new bool[my_map.size() * maxtime]();  // initialized to false
-					SingleAgentECBS single(cons_paths, starts[j]->h_val, my_map, i, agents[i]->loc, starts[j]->loc, col, timestep, maxtime);
-					if (single.findPath(1, NULL, res_table, maxtime) == false)
-						cout << "NO SOLUTION EXISTS";
-					int path = single.path.size();
-					//cout << path << "	";
-					cost(i, j) = (2 * col*row - path)*agents.size()*starts.size();
-					delete[] res_table;
+					vector<unsigned int> &cand = candidates[nearest[k].second];
+					if (find(cand.begin(), cand.end(), j) == cand.end())
+						cand.push_back(j);
 				}
 			}
-			for (unsigned int j = tasks.size(); j < starts.size(); j++)
+		}
+		int64_t weight = col*row; //longer than any path
+		int64_t task_weight = weight * (this->agents.size() + 1);
+		vector<vector<pair<int, int64_t> > > edges(agents.size());
+		for (unsigned int i = 0; i < agents.size(); i++)
+		{
+			if (tasks.size() < agents.size() && find(candidates[i].begin(), candidates[i].end(), tasks.size() + i) == candidates[i].end())
+				candidates[i].push_back(tasks.size() + i);
+			for (unsigned int k = 0; k < candidates[i].size(); k++)
+			{
+				unsigned int j = candidates[i][k];
+				int64_t path = path_len[i][j];
+				edges[i].push_back(make_pair(j, j < tasks.size() ? (2 * weight - path) * task_weight : weight * task_weight - path));
+			}
+		}
+		if (assign_prices.empty())
+			assign_prices.resize(my_map.size(), 0);
+		vector<int64_t> prices(starts.size());
+		for (unsigned int j = 0; j < starts.size(); j++)
+			prices[j] = assign_prices[starts[j]->loc];
+		vector<int> auction;
+		assigned = auctionAssignment(edges, starts.size(), prices, auction);
+		if (assigned)
+		{
+			for (unsigned int j = 0; j < starts.size(); j++)
+				assign_prices[starts[j]->loc] = prices[j];
+			assignment.assign(auction.begin(), auction.end());
+		}
+		//otherwise the candidate edges admit no assignment of all agents, so fall back to the dense matrix
+	}
+	if (!assigned)
+	{
+		dlib::matrix<int> cost(starts.size(), starts.size());
+		for (unsigned int i = 0; i < starts.size(); i++)
+		{
+			if (i >= agents.size())
 			{
-				if (starts[j]->h_val[agents[i]->loc] == -1)
+				for (unsigned int j = 0; j < starts.size(); j++)
 				{
 					cost(i, j) = 0;
-					system("PAUSE");
 				}
-				else
+			}
+			else
+			{
+				for (unsigned int j = 0; j < tasks.size(); j++)
 				{
-					bool* res_table = new bool[my_map.size() * maxtime]();  // initialized to false
-					SingleAgentECBS single(cons_paths, starts[j]->h_val, my_map, i, agents[i]->loc, starts[j]->loc, col, timestep, maxtime);
-					if (single.findPath(1, NULL, res_table, maxtime) == false)
-						cout << "NO SOLUTION EXISTS";
-					int path = single.path.size();
-					//cout << -path << "	";
-					cost(i, j) = col*row*agents.size()*starts.size() - path;
-					delete[] res_table;
+					if (starts[j]->h_val[agents[i]->loc] == -1)
+					{
+						cost(i, j) = 0;
+						system("PAUSE");
+					}
+					else
+					{
+						int path = path_len[i][j];
+						//cout << path << "	";
+						cost(i, j) = (2 * col*row - path)*agents.size()*starts.size();
+					}
 				}
+				for (unsigned int j = tasks.size(); j < starts.size(); j++)
+				{
+					if (starts[j]->h_val[agents[i]->loc] == -1)
+					{
+						cost(i, j) = 0;
+						system("PAUSE");
+					}
+					else
+					{
+						int path = path_len[i][j];
+						//cout << -path << "	";
+						cost(i, j) = col*row*agents.size()*starts.size() - path;
+					}
+				}
+				//cout << endl;
 			}
-			//cout << endl;
 		}
+		
+		// To find out the best assignment of people to jobs we just need to call this function.
+		assignment = max_cost_assignment(cost);
 	}
-	
-	// To find out the best assignment of people to jobs we just need to call this function.
-	vector<long> assignment = max_cost_assignment(cost);
 
 	
 	//assign
@@ -251,9 +386,42 @@ void Simulation::AssignTasks(vector<Agent*> &agents, const vector<vector<int> >
 }
 bool Simulation::PathFinding(vector<Agent*> &agents, const vector<vector<int> > &cons_paths)
 {
-	ECBSSearch ecbs(my_map, agents, cons_paths, timestep, col, focal_w);
-	if (ecbs.runECBSSearch())
+	//warm start from the agents' current plans (ECBSSearch keeps those that are still valid for their next endpoint)
+	vector<vector<int> > warm_paths;
+	if (warm_start)
 	{
+		for (unsigned int i = 0; i < agents.size(); i++)
+		{
+			unsigned int arrive = maxtime - 1;
+			while (arrive > timestep && agents[i]->path[arrive - 1] == agents[i]->path[maxtime - 1])
+				arrive--;
+			warm_paths.push_back(vector<int>(agents[i]->path.begin() + timestep, agents[i]->path.begin() + arrive + 1));
+		}
+	}
+	ECBSSearch ecbs(my_map, agents, cons_paths, timestep, col, focal_w, window, warm_start ? &warm_paths : NULL);
+	ecbs.parallel_children = parallel_children;
+	ecbs.time_budget = plan_budget;
+	//prioritized planning is much cheaper and often good enough (within the focal weight of the lower bound)
+	bool solved = prioritized_first && ecbs.runPrioritizedSearch();
+	if (!solved)
+		solved = ecbs.runECBSSearch();
+	if (!solved)
+	{
+		//ecbs.paths hold the best node found, replan its colliding agents one by one
+		solved = ecbs.repairPaths();
+		cout << "ECBS " << (ecbs.timed_out ? "ran out of time" : "found no solution") << ", repair "
+			<< (solved ? "succeeded" : "failed") << endl;
+	}
+	if (solved)
+	{
+		//starts of the waiting tasks, where an agent without a task picks one up
+		vector<bool> waiting_start;
+		if (event_driven)
+		{
+			waiting_start.resize(my_map.size(), false);
+			for (list<Task*>::iterator it = tasks_assign.begin(); it != tasks_assign.end(); it++)
+				waiting_start[(*it)->start->loc] = true;
+		}
 		//update
 		for (unsigned int i = 0; i < agents.size(); i++)
 		{
@@ -274,24 +442,57 @@ bool Simulation::PathFinding(vector<Agent*> &agents, const vector<vector<int> >
 				agents[i]->task->ag_arrive_goal= timestep + ecbs.paths[i].size() - 1;
 			}
 			agents[i]->task = NULL;
+			agents[i]->plan_time = timestep;
+			plan_cost += ecbs.paths[i].size() - 1;
+			//events: the agent delivers its task, picks up a task on its way or is due for replanning
+			if (event_driven)
+			{
+				if (agents[i]->delivering == true)
+				{
+					events.push(timestep + ecbs.paths[i].size() - 1);
+				}
+				else
+				{
+					for (unsigned int j = 1; j < ecbs.paths[i].size(); j++)
+					{
+						if (waiting_start[ecbs.paths[i][j]])
+						{
+							events.push(timestep + j);
+							break;
+						}
+					}
+				}
+				if (window > 0)
+					events.push(timestep + replan_period);
+			}
 		}
+		plan_lower_bound += ecbs.min_sum_f_vals;
 		return true;
 	}
 	else
 	{
 		cout << "CBS fails" << endl;
-		std::system("PAUSE");
+		plan_failed = true;
+		if (event_driven)
+			events.push(timestep + 1);
 		//Recovery. Let robots move along its original paths.
 		for (unsigned int i = 0; i < agents.size(); i++)
 		{
-			if (agents[i]->delivering == true)
+			if (agents[i]->delivering == true && agents[i]->task->ag_arrive_start < timestep)
+			{
+				//a package agent due for replanning (rolling horizon) keeps its task, goal and old path;
+				//its plan_time is unchanged, so run puts it in ag_replan again at the next timestep
+				agents[i]->task = NULL;
+				continue;
+			}
+			if (agents[i]->delivering == true) //picked up its package at this timestep
 			{
 				agents[i]->delivering = false;
 				DeliverGoal[agents[i]->task->goal->loc] = false;
 				agents[i]->task->delivering = false;
 				agents[i]->task->ag = NULL;
 				tasks_assign.push_back(agents[i]->task);
-				tasks_deliver.pop_back();
+				tasks_deliver.remove(agents[i]->task);
 			}
 			agents[i]->task = NULL;
 			agents[i]->next_ep = NULL;
@@ -304,12 +505,27 @@ bool Simulation::PathFinding(vector<Agent*> &agents, const vector<vector<int> >
 void Simulation::run(double focal_w)
 {
 	this->focal_w = focal_w;
+	min_focal_w = focal_w;
+	chrono::steady_clock::time_point run_start = chrono::steady_clock::now();
+	if (event_driven)
+	{
+		for (unsigned int t = 0; t < tasks_total.size(); t++)
+			if (!tasks_total[t].empty())
+				events.push(t);
+	}
 	for (timestep = 0; timestep <= t_task || !tasks_assign.empty(); timestep++)
 	{
+		if (time_limit > 0 && chrono::duration<double>(chrono::steady_clock::now() - run_start).count() > time_limit)
+		{
+			cerr << "Time limit reached at timestep " << timestep << endl;
+			break;
+		}
 		cout << endl << "Timestep " << timestep << endl;
 		vector<Agent*> ag_pathfinding;
 		vector<Agent*> ag_assign;
+		vector<Agent*> ag_replan;
 		vector<vector<int> > cons_paths;
+		bool changed = plan_failed || !tasks_total[timestep].empty(); //whether the plan of this timestep may differ from the last one
 		// delete FINISH tasks 	and update its agent's state	
 		for (list<Task*>::iterator it = tasks_deliver.begin(); it != tasks_deliver.end();)
 		{
@@ -320,6 +536,7 @@ void Simulation::run(double focal_w)
 				DeliverGoal[(*it)->goal->loc] = false;
 				list<Task*>::iterator done = it++;
 				tasks_deliver.erase(done);
+				changed = true;
 			}
 			else
 			{
@@ -343,7 +560,13 @@ void Simulation::run(double focal_w)
 			agents[i].loc = agents[i].path[timestep];
 			ag_hold[agents[i].path[maxtime - 1]] = i; //record every agent's holding point
 			if (agents[i].delivering == false)
+			{
 				ag_loc[agents[i].loc] = i; // record non_package agents current loc
+				if (window > 0 && timestep - agents[i].plan_time >= replan_period)
+					changed = true; //its path is only known to be collision free within the window
+			}
+			else if (window > 0 && timestep - agents[i].plan_time >= replan_period)
+				ag_replan.push_back(&agents[i]); //its path is only known to be collision free within the window
 			else
 				cons_paths.push_back(agents[i].path); //record package agents' paths
 		}
@@ -377,18 +600,38 @@ void Simulation::run(double focal_w)
 			}
 		}
 
+		//package agents due for replanning (rolling horizon) are planned together with the new ones
+		for (list<Task*>::iterator it = tasks_deliver.begin(); it != tasks_deliver.end() && !ag_replan.empty(); it++)
+		{
+			vector<Agent*>::iterator ag = find(ag_replan.begin(), ag_replan.end(), (*it)->ag);
+			if (ag != ag_replan.end())
+			{
+				(*ag)->task = *it;
+				ag_pathfinding.push_back(*ag);
+				ag_replan.erase(ag);
+			}
+		}
+
+		if (skip_idle && !changed && ag_pathfinding.empty())
+			continue; //nothing happened since the last plan, so every agent keeps following its collision free path
 		num_computations++;
+		plan_failed = false;
 		clock_t start = std::clock();
+		chrono::steady_clock::time_point plan_start = chrono::steady_clock::now();
+		plan_cost = 0;
+		plan_lower_bound = 0;
 
-		if (!ag_pathfinding.empty()) //path finding
+		//in batch mode the new DELIVER agents are planned in one ECBS search together with the others (below),
+		//and AssignTasks only sees the paths of the DELIVER agents that keep their plans
+		if (!ag_pathfinding.empty() && !batch_planning) //path finding
 		{
 			PathFinding(ag_pathfinding, cons_paths);
 			for (int i = 0; i < ag_pathfinding.size(); i++)
 			{
 				cons_paths.push_back(ag_pathfinding[i]->path);
 			}
+			ag_pathfinding.clear();
 		}
-		ag_pathfinding.clear();
 
 		//pick off non-package agents and 				
 		//cout << "Non-package agents:	";
@@ -423,11 +666,32 @@ void Simulation::run(double focal_w)
 		
 		computation_time += (std::clock() - start);
 
-		if (!TestConstraints()) //test correctness
+		if (latency_target > 0)
+		{
+			double latency = chrono::duration<double>(chrono::steady_clock::now() - plan_start).count();
+			cout << "Focal weight " << this->focal_w << ": planning took " << latency << " s, sum of costs "
+				<< plan_cost << " (lower bound " << plan_lower_bound << ")" << endl;
+			//raise the weight while planning is slower than the target, and lower it back
+			//towards the given weight while there is plenty of slack
+			if (latency > latency_target)
+				this->focal_w = min(max_focal_w, this->focal_w + 0.1);
+			else if (latency < latency_target / 2)
+				this->focal_w = max(min_focal_w, this->focal_w - 0.05);
+		}
+
+		if (verify_period > 0 && timestep % verify_period == 0 && !TestConstraints()) //test correctness
 		{
 			std::system("PAUSE");
 		}
-		
+
+		if (event_driven)
+		{
+			//jump to the next timestep where something happens, the agents just follow their paths until then
+			while (!events.empty() && events.top() <= timestep)
+				events.pop();
+			if (!events.empty())
+				timestep = events.top() - 1;
+		}
 	}
 }
 
@@ -443,6 +707,7 @@ void Simulation::ShowTask()
 			//cout << "Timestep " << i<<" :	";
 			for (list<Task>::iterator it = tasks_total[i].begin(); it != tasks_total[i].end(); it++)
 			{
+				if (it->ag == NULL) continue; //not taken before the run stopped
 				//cout << "(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")	";
 				WaitingTime += it->ag_arrive_goal - i;
 				LastFinish = LastFinish > it->ag_arrive_goal ? LastFinish : it->ag_arrive_goal;
@@ -468,6 +733,7 @@ void Simulation::SaveTask(const string &fname, const string &instance_name)
 			//fout << "Timestep " << i << " :	";
 			for (list<Task>::iterator it = tasks_total[i].begin(); it != tasks_total[i].end(); it++)
 			{
+				if (it->ag == NULL) continue; //not taken before the run stopped
 				//fout << "Agent " << it->ag->id << " delivers package from " << it->start->loc << " to " << it->goal->loc
 				//	<< "	(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")" << endl;
 				WaitingTime += it->ag_arrive_goal - i;
@@ -500,6 +766,7 @@ void Simulation::SaveThroughput(const string &fname)
 			//fout << "Timestep " << i << " :	";
 			for (list<Task>::iterator it = tasks_total[i].begin(); it != tasks_total[i].end(); it++)
 			{
+				if (it->ag == NULL) continue; //not taken before the run stopped
 				//fout << "Agent " << it->ag->id << " delivers package from " << it->start->loc << " to " << it->goal->loc
 				//	<< "	(" << it->ag_arrive_start << "," << it->ag_arrive_goal << ")" << endl;
 				for (int time = 0; time < 100; time++) {
@@ -543,25 +810,80 @@ void Simulation::SavePath(string fname)
 
 bool Simulation::TestConstraints()
 {
+	//with a rolling horizon, every path was planned within the last replan_period timesteps
+	//and is only collision free up to window timesteps after that
+	unsigned int end = maxtime;
+	if (window > 0 && timestep + window - replan_period + 2 < end)
+		end = timestep + window - replan_period + 2;
+	if (!verify_incremental)
+	{
+		for (unsigned int ag = 0; ag < agents.size(); ag++)
+		{
+			if (!TestCollisions(ag, ag + 1, timestep + 1, end))
+				return false;
+		}
+		return true;
+	}
+
+	//incremental: keep a reservation index of all paths, and only check the paths written since the last test
+	//(and, with a window, the timesteps that became checkable since then) against it
+	bool first = verified_paths == NULL;
+	if (first)
+	{
+		verified_paths = new ReservationTable(my_map.size(), agents.size());
+		verified_end = end;
+	}
+	vector<bool> changed(agents.size(), false);
+	for (unsigned int ag = 0; ag < agents.size(); ag++)
+	{
+		if (first || agents[ag].plan_time > verified_timestep)
+		{
+			//the agent stays at its last location from arrive on
+			unsigned int arrive = maxtime - 1;
+			while (arrive > 0 && agents[ag].path[arrive - 1] == agents[ag].path[maxtime - 1])
+				arrive--;
+			verified_paths->setPath(ag, vector<int>(agents[ag].path.begin(), agents[ag].path.begin() + arrive + 1));
+			changed[ag] = true;
+		}
+	}
+	verified_timestep = timestep;
 	for (unsigned int ag = 0; ag < agents.size(); ag++)
 	{
-		for (unsigned int i = ag + 1; i < agents.size(); i++)
+		unsigned int begin = changed[ag] ? timestep + 1 : max(verified_end, timestep + 1);
+		for (unsigned int j = begin; j < end; j++)
 		{
-			for (unsigned int j = timestep + 1; j < maxtime; j++)
+			int loc = agents[ag].path[j], prev = agents[ag].path[j - 1];
+			bool suspect = verified_paths->isReserved(loc, j, ag);
+			//the index only tells that some agents are at prev at j and at loc at j - 1, maybe not the same one
+			if (!suspect && timestep > 0 && prev != loc)
+				suspect = verified_paths->isReserved(prev, j, ag) && verified_paths->isReserved(loc, j - 1, ag);
+			if (suspect && !TestCollisions(ag, 0, j, j + 1))
+				return false;
+		}
+	}
+	verified_end = end;
+	return true;
+}
+bool Simulation::TestCollisions(unsigned int ag, unsigned int first, unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = first; i < agents.size(); i++)
+	{
+		if (i == ag)
+			continue;
+		for (unsigned int j = begin; j < end; j++)
+		{
+			if (agents[ag].path[j] == agents[i].path[j])
 			{
-				if (agents[ag].path[j] == agents[i].path[j])
-				{
-					cout << "Agent " << ag << " and " << i << " collide at location " 
-						<< agents[ag].path[j] << " at time " << j << endl;
-					return false;
-				}
-				else if (timestep > 0 && agents[ag].path[j] == agents[i].path[j - 1]
-					&& agents[ag].path[j - 1] == agents[i].path[j])
-				{
-					cout << "Agent " << ag << " and " << i << " collide at edge "
-						<< agents[ag].path[j - 1] << "-" << agents[ag].path[j] << " at time " << j << endl;
-					return false;
-				}
+				cout << "Agent " << ag << " and " << i << " collide at location " 
+					<< agents[ag].path[j] << " at time " << j << endl;
+				return false;
+			}
+			else if (timestep > 0 && agents[ag].path[j] == agents[i].path[j - 1]
+				&& agents[ag].path[j - 1] == agents[i].path[j])
+			{
+				cout << "Agent " << ag << " and " << i << " collide at edge "
+					<< agents[ag].path[j - 1] << "-" << agents[ag].path[j] << " at time " << j << endl;
+				return false;
 			}
 		}
 	}
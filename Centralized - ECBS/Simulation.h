@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <climits>
+#include <queue>
+#include <functional>
 
 using namespace std;
 
@@ -20,10 +22,13 @@ using namespace std;
 #include "Agent.h"
 
 #include "ecbs_search.h"
+#include "reservation_table.h"
+#include "auction_assignment.h"
 
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
 
 class Simulation
 {
@@ -45,6 +50,23 @@ public:
 
 	double computation_time;
 	int num_computations;
+	double time_limit; //wall-clock seconds for the whole run, 0 means no limit
+	bool parallel_children; //replan the two children of each high-level ECBS node on two threads
+	double plan_budget; //wall-clock seconds for each high-level ECBS search, 0 means no limit
+	int window; //rolling horizon: ECBS only resolves collisions within window timesteps, 0 means the whole paths
+	int replan_period; //with a window, delivering agents replan every replan_period (<= window) timesteps
+	bool warm_start; //start each ECBS search from the agents' previous paths that are still valid
+	int assign_candidates; //AssignTasks searches paths to this many nearest starts per agent (BFS distances for the rest), -1 for all
+	unsigned int assign_threads; //threads filling AssignTasks' cost matrix
+	bool auction_assign; //AssignTasks runs a sparse auction over the candidate starts instead of the dense Hungarian method
+	bool batch_planning; //plan the new DELIVER agents and the assigned ones in a single ECBS search per timestep
+	bool skip_idle; //skip planning at timesteps without new or finished tasks, new DELIVER agents or due replanning
+	int verify_period; //test the paths for collisions every verify_period timesteps, 0 never
+	bool verify_incremental; //test only the paths written since the last test, against an index of all paths
+	bool prioritized_first; //try prioritized planning before each ECBS search
+	double latency_target; //wall-clock seconds of planning per timestep to tune focal_w for, 0 keeps it fixed
+	double max_focal_w; //the tuned focal_w stays between the weight given to run and this
+	bool event_driven; //jump between the timesteps where tasks appear, agents reach their goals or are due for replanning
 
 private:
 	// initialize
@@ -54,12 +76,16 @@ private:
 	void AssignTasks(vector<Agent*> &agents, const vector<vector<int> > &cons_paths);
 	bool PathFinding(vector<Agent*> &agents, const vector<vector<int> > &cons_paths);
 	bool TestConstraints();
+	bool TestCollisions(unsigned int ag, unsigned int first, unsigned int begin, unsigned int end); //agent ag against agents first.. within [begin, end)
 	
 private:
 	int row, col;
 	vector<bool> my_map;
 	vector<bool> DeliverGoal; //goals of DELIVER tasks
 	double focal_w;
+	double min_focal_w;//the focal weight given to run, the lower limit of the tuned focal_w
+	double plan_cost;//sum of costs of the paths planned at this timestep
+	double plan_lower_bound;//sum of the lower bounds of the ECBS searches that planned them
 	//task
 	vector<list<Task>> tasks_total;
 	list<Task*> tasks_assign;
@@ -71,11 +97,17 @@ private:
 
 	unsigned int maxtime;//map_size * num_agents
 	unsigned int timestep;
+	bool plan_failed;//the last PathFinding fell back to the agents' old paths
+	ReservationTable* verified_paths;//paths as of the last incremental TestConstraints
+	unsigned int verified_timestep;//timestep of the last incremental TestConstraints
+	unsigned int verified_end;//the paths were collision free before this timestep at the last incremental TestConstraints
+	priority_queue<unsigned int, vector<unsigned int>, greater<unsigned int> > events;//timesteps where the simulation state changes
 	
 	
 	int workpoint_num;
 	int t_task;//timestep of last task
 
 	vector<int> endpoint_hashtable;//loc->endpointID
+	vector<int64_t> assign_prices;//loc->auction price of the endpoint (benefit units), kept between timesteps to warm-start AssignTasks
 };
 
@@ -0,0 +1,108 @@
+#include "auction_assignment.h"
+#include <algorithm>
+#include <queue>
+#include <functional>
+
+
+bool auctionAssignment(const vector< vector< pair<int, int64_t> > >& edges, int num_objects,
+                       vector<int64_t>& prices, vector<int>& assignment) {
+  int num_persons = edges.size();
+  assignment.assign(num_persons, -1);
+  if (num_persons == 0)
+    return true;
+  if (num_persons > num_objects)
+    return false;
+  // persons num_persons..num_objects-1 pad the problem to a square one and have benefit 0 for every object
+  int64_t scale = num_objects + 1;
+  int64_t max_benefit = 0, min_benefit = 0;
+  for (int i = 0; i < num_persons; i++) {
+    if (edges[i].empty())
+      return false;
+    for (size_t k = 0; k < edges[i].size(); k++) {
+      max_benefit = std::max(max_benefit, edges[i][k].second);
+      min_benefit = std::min(min_benefit, edges[i][k].second);
+    }
+  }
+  // prices stay below price_limit (about 2 * max_price + 4 * num_objects * range), which has to fit in int64_t
+  if (max_benefit - min_benefit > INT64_MAX / 8 / scale / scale)
+    return false;
+  int64_t range = (max_benefit - min_benefit) * scale;
+
+  // only price differences matter, so the cheapest object is moved to price 0
+  prices.resize(num_objects, 0);
+  int64_t min_price = *std::min_element(prices.begin(), prices.end());
+  if (*std::max_element(prices.begin(), prices.end()) - min_price > INT64_MAX / 4 / scale) {
+    prices.assign(num_objects, 0);  // too far apart to scale, so the search starts cold
+    min_price = 0;
+  }
+  for (int j = 0; j < num_objects; j++)
+    prices[j] = (prices[j] - min_price) * scale;
+  int64_t max_price = *std::max_element(prices.begin(), prices.end());
+
+  // epsilon scaling; warm prices are closer to the final ones, so they skip the first (coarsest) phases
+  int64_t epsilon = std::max(range / (max_price > 0 ? 16 : 4), (int64_t)1);
+  vector<int> owner(num_objects);
+  while (true) {
+    // with a feasible problem no price rises this much within a phase, so the persons' edges admit no assignment
+    int64_t price_limit = 2 * max_price + 2 * (int64_t)num_objects * (range + epsilon);
+    owner.assign(num_objects, -1);
+    vector<int> person_object(num_objects, -1);
+    vector<int> unassigned;
+    for (int p = num_objects - 1; p >= 0; p--)
+      unassigned.push_back(p);
+    // cheapest objects for the padding persons; prices only rise, so outdated entries are skipped when popped
+    typedef pair<int64_t, int> PriceEntry;
+    std::priority_queue<PriceEntry, vector<PriceEntry>, std::greater<PriceEntry> > cheapest;
+    for (int j = 0; j < num_objects; j++)
+      cheapest.push(PriceEntry(prices[j], j));
+
+    while (!unassigned.empty()) {
+      int p = unassigned.back();
+      unassigned.pop_back();
+      int best = -1;
+      int64_t best_value = 0, second_value = 0;
+      if (p < num_persons) {
+        for (size_t k = 0; k < edges[p].size(); k++) {
+          int64_t value = edges[p][k].second * scale - prices[edges[p][k].first];
+          if (best < 0 || value > best_value) {
+            second_value = best < 0 ? value - range : best_value;  // with one edge, any price is worth paying
+            best = edges[p][k].first;
+            best_value = value;
+          } else if (value > second_value) {
+            second_value = value;
+          }
+        }
+      } else {
+        while (cheapest.top().first != prices[cheapest.top().second])
+          cheapest.pop();
+        best = cheapest.top().second;
+        best_value = -prices[best];
+        cheapest.pop();
+        while (!cheapest.empty() && cheapest.top().first != prices[cheapest.top().second])
+          cheapest.pop();
+        second_value = cheapest.empty() ? best_value : -cheapest.top().first;
+      }
+
+      prices[best] += best_value - second_value + epsilon;
+      if (prices[best] > price_limit)
+        return false;
+      cheapest.push(PriceEntry(prices[best], best));
+      if (owner[best] >= 0) {
+        person_object[owner[best]] = -1;
+        unassigned.push_back(owner[best]);
+      }
+      owner[best] = p;
+      person_object[p] = best;
+    }
+
+    if (epsilon == 1) {
+      for (int i = 0; i < num_persons; i++)
+        assignment[i] = person_object[i];
+      for (int j = 0; j < num_objects; j++)
+        prices[j] /= scale;
+      return true;
+    }
+    epsilon = std::max(epsilon / 4, (int64_t)1);
+    max_price = *std::max_element(prices.begin(), prices.end());
+  }
+}
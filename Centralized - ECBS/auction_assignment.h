@@ -0,0 +1,25 @@
+// Sparse auction solver for the task assignment
+#ifndef AUCTIONASSIGNMENT_H
+#define AUCTIONASSIGNMENT_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+using std::vector;
+using std::pair;
+
+/* Assigns each person to a distinct object (there are num_objects >= edges.size() objects) maximizing the total
+   benefit, where person i may only take the objects listed in edges[i] as (object, benefit) pairs.
+   This is the problem max_cost_assignment solves on the square matrix padded with zero rows, but a bid only scans
+   the edges of the bidder, so a few candidate edges per person replace the dense objects x objects matrix.
+   Benefits are scaled by num_objects + 1 internally, so the last epsilon phase (epsilon = 1) gives an optimal
+   assignment. prices (one per object, in benefit units) are the starting prices and are updated in place: any
+   starting prices are valid, and those of the previous timestep let the search skip the coarsest phases.
+   Returns false if the edges admit no assignment of all persons, or if the benefits are too far apart for the
+   scaled prices to fit in int64_t (assignment is then undefined).
+ */
+bool auctionAssignment(const vector< vector< pair<int, int64_t> > >& edges, int num_objects,
+                       vector<int64_t>& prices, vector<int>& assignment);
+
+#endif
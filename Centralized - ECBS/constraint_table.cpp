@@ -0,0 +1,79 @@
+#include "constraint_table.h"
+#include <climits>
+
+
+ConstraintTable::ConstraintTable(int map_size) : map_size(map_size) {
+  vertex_cons.set_empty_key(-1);
+  edge_cons.set_empty_key(-1);
+  hold_cons.set_empty_key(-1);
+  latest.set_empty_key(-1);
+}
+
+
+void ConstraintTable::updateLatest(int loc, int timestep) {
+  dense_hash_map<int, int>::iterator it = latest.find(loc);
+  if (it == latest.end())
+    latest[loc] = timestep;
+  else if (it->second < timestep)
+    it->second = timestep;
+}
+
+
+void ConstraintTable::addVertex(int loc, int timestep) {
+  vertex_cons[loc + (int64_t)timestep * map_size] = true;
+  updateLatest(loc, timestep);
+}
+
+
+void ConstraintTable::addEdge(int loc1, int loc2, int timestep) {
+  edge_cons[((int64_t)timestep * map_size + loc1) * map_size + loc2] = true;
+  updateLatest(loc1, timestep);
+  updateLatest(loc2, timestep);
+}
+
+
+void ConstraintTable::addHold(int loc, int timestep) {
+  dense_hash_map<int, int>::iterator it = hold_cons.find(loc);
+  if (it == hold_cons.end())
+    hold_cons[loc] = timestep;
+  else if (it->second > timestep)
+    it->second = timestep;
+  latest[loc] = INT_MAX;
+}
+
+
+void ConstraintTable::addPath(const vector<int>& path, int start_time) {
+  if ((int)path.size() <= start_time)
+    return;
+  // the agent stays at its last location from arrive_time on
+  int arrive_time = path.size() - 1;
+  while (arrive_time > start_time && path[arrive_time-1] == path.back())
+    arrive_time--;
+  for (int t = start_time; t < arrive_time; t++) {
+    addVertex(path[t], t - start_time);
+    // moving from path[t+1] to path[t] would swap with the agent
+    addEdge(path[t+1], path[t], t - start_time);
+  }
+  addHold(path.back(), arrive_time - start_time);
+}
+
+
+bool ConstraintTable::isConstrained(int curr_loc, int next_loc, int next_timestep) const {
+  if (vertex_cons.find(next_loc + (int64_t)next_timestep * map_size) != vertex_cons.end())
+    return true;
+  dense_hash_map<int, int>::const_iterator it = hold_cons.find(next_loc);
+  if (it != hold_cons.end() && it->second <= next_timestep)
+    return true;
+  if (next_timestep > 0 &&
+      edge_cons.find(((int64_t)(next_timestep-1) * map_size + curr_loc) * map_size + next_loc) != edge_cons.end())
+    return true;
+  return false;
+}
+
+
+int ConstraintTable::getLatestTimestep(int loc) const {
+  dense_hash_map<int, int>::const_iterator it = latest.find(loc);
+  if (it == latest.end())
+    return -1;
+  return it->second;
+}
@@ -0,0 +1,49 @@
+// Hashed set of (hard) constraints for the low-level search
+#ifndef CONSTRAINTTABLE_H
+#define CONSTRAINTTABLE_H
+
+#include <stdint.h>
+#include <vector>
+#include <google/dense_hash_map>
+
+using std::vector;
+using google::dense_hash_map;
+
+/* Vertex constraints keyed by (loc, t) and edge constraints keyed by (loc1, loc2, t), so a check costs O(1)
+   regardless of how many constraints (or paths of other agents) there are.
+   Also keeps, for each location, the latest timestep with a constraint on it (used for goal tests).
+ */
+class ConstraintTable {
+ public:
+  explicit ConstraintTable(int map_size);
+
+  void addVertex(int loc, int timestep);  // being at loc at timestep is disallowed
+  void addEdge(int loc1, int loc2, int timestep);  // the move from loc1 (at timestep) to loc2 (at timestep+1) is disallowed
+  void addHold(int loc, int timestep);  // being at loc at timestep or later is disallowed
+
+  /* Disallows colliding with an agent moving along path (path[start_time] is at timestep 0 of this table).
+     The agent is assumed to stay at its last location, so only the moving part is hashed.
+   */
+  void addPath(const vector<int>& path, int start_time);
+
+  /* Returns true if the move from curr_loc (at next_timestep-1) to next_loc (at next_timestep) is disallowed.
+   */
+  bool isConstrained(int curr_loc, int next_loc, int next_timestep) const;
+
+  /* Returns the latest timestep with a constraint involving loc (INT_MAX if it is held, -1 if none).
+   */
+  int getLatestTimestep(int loc) const;
+
+  ~ConstraintTable() {}
+
+ private:
+  int map_size;
+  dense_hash_map<int64_t, bool> vertex_cons;  // loc + t*map_size
+  dense_hash_map<int64_t, bool> edge_cons;  // (t*map_size + loc1)*map_size + loc2
+  dense_hash_map<int, int> hold_cons;  // loc -> earliest timestep it is held from
+  dense_hash_map<int, int> latest;  // loc -> latest timestep with a constraint on it
+
+  void updateLatest(int loc, int timestep);
+};
+
+#endif
@@ -5,6 +5,9 @@
 ECBSNode::ECBSNode() {
   agent_id = -1;
   constraint = make_tuple(-1, -1, -1);
+  parent = NULL;
+  agent_parent = NULL;
+  depth = 0;
   g_val = 0;
   h_val = 0;
   time_expanded = -1;
@@ -14,6 +17,8 @@ ECBSNode::ECBSNode() {
 ECBSNode::ECBSNode(int agent_id, ECBSNode* parent, double g_val, double h_val, int time_expanded, double sum_min_f_vals):
     agent_id(agent_id), parent(parent), g_val(g_val), h_val(h_val), time_expanded(time_expanded), sum_min_f_vals(sum_min_f_vals) {
   constraint = make_tuple(-1, -1, -1);
+  agent_parent = NULL;
+  depth = parent == NULL ? 0 : parent->depth + 1;
 }
 
 
@@ -20,7 +20,9 @@ class ECBSNode {
   int agent_id;
   tuple<int, int, int> constraint;  // <int loc1, int loc2, int timestep> NOTE--loc2=-1 for Vertex Constraint
   ECBSNode* parent;
-  vector<int> path;
+  ECBSNode* agent_parent;  // the youngest ancestor constraining the same agent (NULL if none), so each agent's constraints form a list shared by all descendants
+  int depth;  // number of constraints from the root
+  vector<int> path;  // the (only) path that differs from parent's solution -- agent_id's
   double g_val;  // (total cost)
   double h_val;  // (number of collisions)
   int time_expanded;
@@ -28,6 +30,7 @@ class ECBSNode {
   double sum_min_f_vals;  // saves the overall sum of min f-vals.
   double ll_min_f_val;  // saves this agent's low-level min-f-val (as reported by the search that found the path stored)
   double path_cost;  // saves this agent's low-level path-cost
+  vector< tuple<int, int, int, int, int> > collisions;  // all collisions among this node's paths (released once expanded)
 
   // the following is used to comapre nodes in the OPEN list
   struct compare_node {
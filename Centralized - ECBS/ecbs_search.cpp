@@ -7,6 +7,9 @@
 #include <tuple>
 #include <ctime>
 #include <climits>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -58,25 +61,9 @@ void ECBSSearch::printPaths() {
 
 }
 
-void ECBSSearch::printResTable(bool* res_table, size_t max_plan_len) {
-  cout << "MAP_SIZE=" << map_size << " ; MAX_PLAN_LEN=" << max_plan_len << endl;
-  for (size_t t = 0; t < max_plan_len; t++) {
-    for (size_t id = 0; id < (size_t)map_size; id++) {
-      if ( res_table[id + t*map_size] == false )
-        cout << '_';
-      else
-        cout << '*';
-    }
-    cout << endl;
-  }
-}
-
-
 inline void ECBSSearch::releaseClosedListNodes() {
-  hashtable_t::iterator it;
-  for (it=allNodes_table.begin(); it != allNodes_table.end(); it++) {
-    delete ( (*it).first );  // should it be .second?
-  }
+  allNodes_table.clear();
+  node_pool.clear();
 }
 
 
@@ -99,32 +86,56 @@ inline double ECBSSearch::compute_hl_lower_bound() {
 
 
 // adding new nodes to FOCAL (those with min-f-val*f_weight between the old and new LB)
+// only the nodes whose lower bound is within the new threshold are visited (and leave open_above_focal), not all of OPEN.
+// high-level nodes leave OPEN only through FOCAL, so all of them are still in OPEN.
 void ECBSSearch::updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight) {
-  for (ECBSNode* n : open_list) {
-    if ( n->sum_min_f_vals > old_lower_bound &&
-         n->sum_min_f_vals <= new_lower_bound )
-      n->focal_handle = focal_list.push(n);
-  }
+  std::multimap<double, ECBSNode*>::iterator last = open_above_focal.upper_bound(new_lower_bound);
+  for (std::multimap<double, ECBSNode*>::iterator it = open_above_focal.begin(); it != last; ++it)
+    it->second->focal_handle = focal_list.push(it->second);
+  open_above_focal.erase(open_above_focal.begin(), last);
 }
 
 
-// takes the paths_found_initially and UPDATE all (constrained) paths found for agents from curr to start
-// also, do the same for ll_min_f_vals and paths_costs (since its already "on the way").
-inline void ECBSSearch::updatePaths(ECBSNode* curr, ECBSNode* root_node) {
-  paths = paths_found_initially;
-  ll_min_f_vals = ll_min_f_vals_found_initially;
-  paths_costs = paths_costs_found_initially;
-  vector<bool> updated(num_of_agents, false);  // initialized for false
-  /* used for backtracking -- only update paths[i] if it wasn't updated before (that is, by a younger node)
-   * because younger nodes take into account ancesstors' nodes constraints. */
-  while ( curr != root_node ) {
-    if (updated[curr->agent_id] == false) {
-      paths[curr->agent_id] = curr->path;
-      ll_min_f_vals[curr->agent_id] = curr->ll_min_f_val;
-      paths_costs[curr->agent_id] = curr->path_cost;
-      updated[curr->agent_id] = true;
+// moves paths (and ll_min_f_vals, paths_costs) from paths_node's solution to curr's.
+// every node only holds the path of the agent it constrains, so only the agents constrained between the two nodes
+// and their common ancestor are updated (in time proportional to the depth difference, not to the whole solution).
+inline void ECBSSearch::updatePaths(ECBSNode* curr) {
+  vector<int> changed;  // agents whose path may differ
+  vector<ECBSNode*> descend;  // nodes from curr up to (excluding) the common ancestor
+  ECBSNode* up = paths_node;
+  ECBSNode* down = curr;
+  while (up != down) {
+    if (up->depth >= down->depth) {
+      // leaving up's branch -- its agent falls back to the next (older) node constraining it
+      agent_nodes[up->agent_id] = up->agent_parent;
+      changed.push_back(up->agent_id);
+      up = up->parent;
+    } else {
+      descend.push_back(down);
+      down = down->parent;
+    }
+  }
+  // younger nodes take into account ancesstors' nodes constraints, so they are applied last
+  for (vector<ECBSNode*>::reverse_iterator it = descend.rbegin(); it != descend.rend(); it++) {
+    agent_nodes[(*it)->agent_id] = *it;
+    changed.push_back((*it)->agent_id);
+  }
+  paths_node = curr;
+
+  sort(changed.begin(), changed.end());
+  changed.erase(unique(changed.begin(), changed.end()), changed.end());
+  for (size_t i = 0; i < changed.size(); i++) {
+    int ag = changed[i];
+    if (agent_nodes[ag] == NULL) {
+      paths[ag] = paths_found_initially[ag];
+      ll_min_f_vals[ag] = ll_min_f_vals_found_initially[ag];
+      paths_costs[ag] = paths_costs_found_initially[ag];
+    } else {
+      paths[ag] = agent_nodes[ag]->path;
+      ll_min_f_vals[ag] = agent_nodes[ag]->ll_min_f_val;
+      paths_costs[ag] = agent_nodes[ag]->path_cost;
     }
-    curr = curr->parent;
+    res_table->setPath(ag, paths[ag]);
   }
 }
 
@@ -138,61 +149,38 @@ void ECBSSearch::updatePathsForExpTime(int t_exp) {
   for (hashtable_t::iterator it=allNodes_table.begin(); it != allNodes_table.end(); it++)
     if ( ((*it).second)->time_expanded == t_exp )
       t_exp_node = (*it).second;
+  if (t_exp_node == NULL)
+    return;  // no kept node was expanded at t_exp
 
-  updatePaths(t_exp_node, dummy_start);
+  updatePaths(t_exp_node);
   //  printPaths();
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// find all constraints on this agent (recursing to the root) and compute (and store) a path satisfying them.
+// find all constraints on this agent (following its agent_parent list) and compute (and store) a path satisfying them.
 // returns true only if such a path exists (otherwise false and path remain empty).
-inline bool ECBSSearch::updateECBSNode(ECBSNode* leaf_node, ECBSNode* root_node) {
-  // extract all constraints on leaf_node->agent_id
-  list < tuple<int, int, int> > constraints;  // each constraint is <L1,L2,T>
+// only reads the search's shared data (paths, res_table) and uses the agent's own search engine,
+// so it may run concurrently for leaves of different agents.
+inline bool ECBSSearch::updateECBSNode(ECBSNode* leaf_node) {
   int agent_id = leaf_node->agent_id;
   //  cout << " update ECBS node for agent:" << agent_id << endl;
-  ECBSNode* curr = leaf_node;
-  //  cout << "  Find all constraints on him:" << endl;
-  while (curr != root_node) {
-    if (curr->agent_id == agent_id) {
-      constraints.push_front(curr->constraint);
-      //      cout << "   L1:" << get<0>(curr->constraint) << " ; L2:" << get<1>(curr->constraint) << " ; T:" << get<2>(curr->constraint) << endl;
-    }
-    curr = curr->parent;
-  }
-  // cout << "  OVERALL #CONS:" << constraints.size() << endl;
-
-  // calc constraints' max_timestep
-  int max_timestep = -1;
-  for (list< tuple<int, int, int> >::iterator it = constraints.begin(); it != constraints.end(); it++)
-    if ( get<2>(*it) > max_timestep )
-      max_timestep = get<2>(*it);
-  // cout << "  Latest constraint's timestep:" << max_timestep << endl;
-
-  // initialize a constraint vector of length max_timestep+1. Each entry is an empty list< pair<int,int> > (loc1,loc2)
-  //  cout << "  Creating a list of constraints (per timestep):" << endl;
-  vector < list< pair<int, int> > >* cons_vec = new vector < list< pair<int, int> > > ( max_timestep+1, list< pair<int, int> > () );
-  for (list< tuple<int, int, int> >::iterator it = constraints.begin(); it != constraints.end(); it++) {
-    //    cout << "   PUSHING a constraint for time:" << get<2>(*it) << " ; (constraint is [" << get<0>(*it) << "," << get<1>(*it) << "])" << endl;
-    cons_vec->at(get<2>(*it)).push_back(make_pair(get<0>(*it), get<1>(*it)));
+
+  // hash the constraints on agent_id by (loc, timestep) so the low-level search checks them in O(1)
+  ConstraintTable cons_table(map_size);
+  for (ECBSNode* curr = leaf_node; curr != NULL; curr = curr->agent_parent) {
+    const tuple<int, int, int>& c = curr->constraint;  // <L1,L2,T>
+    if (get<1>(c) == -1)
+      cons_table.addVertex(get<0>(c), get<2>(c));
+    else
+      cons_table.addEdge(get<0>(c), get<1>(c), get<2>(c));
   }
 
-  // build reservation table
+  // the reservation table is kept up to date with paths by updatePaths (agent_id's own path is ignored by the search)
   size_t max_plan_len = getPathsMaxLength();
-  bool* res_table = new bool[map_size * max_plan_len]();  // initialized to false
-  updateReservationTable(res_table, max_plan_len, agent_id);
-
-  //  printResTable(res_table, max_plan_len);
 
-  // find a path w.r.t cons_vec (and prioretize by res_table).
-  bool foundSol = search_engines[agent_id]->findPath(focal_w, cons_vec, res_table, max_plan_len);
-  LL_num_expanded += search_engines[agent_id]->num_expanded;
-  LL_num_generated += search_engines[agent_id]->num_generated;
-
-#ifndef NDEBUG
-  cout << "Run search for AG" << agent_id << " ; found solution? " << std::boolalpha << foundSol;
-#endif
+  // find a path w.r.t cons_table (and prioretize by res_table).
+  bool foundSol = search_engines[agent_id]->findPath(focal_w, &cons_table, res_table, max_plan_len, agent_id);
   // update leaf's path to the one found and its low-level search's min f-val
   if (foundSol) {
     leaf_node->path = search_engines[agent_id]->path;
@@ -206,13 +194,27 @@ inline bool ECBSSearch::updateECBSNode(ECBSNode* leaf_node, ECBSNode* root_node)
   }
   //  cout << endl;
 
-  // release memory allocated here and return
-  delete (cons_vec);
-  delete[] res_table;
   return foundSol;
 }
 ////////////////////////////////////////////////////////////////////////////////
 
+// waits for a child in child_job, replans it and hands the result back, until child_stop is set
+void ECBSSearch::replanChildren() {
+  std::unique_lock<std::mutex> lock(child_mutex);
+  while (true) {
+    child_cv.wait(lock, [this]() { return child_job != NULL || child_stop; });
+    if (child_stop)
+      return;
+    lock.unlock();
+    bool found = updateECBSNode(child_job);  // child_job is not touched by the search thread until it is reset
+    lock.lock();
+    child_found = found;
+    child_job = NULL;
+    child_cv.notify_one();
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+
 /*
   return agent_id's location for the given timestep
   Note -- if timestep is longer than its plan length,
@@ -243,37 +245,93 @@ inline bool ECBSSearch::switchedLocations(int agent1_id, int agent2_id, size_t t
   Emulate agents' paths and returns a vector of collisions
   Note - a collision is a tuple of <int agent1_id, agent2_id, int location1, int location2, int timestep>).
   Note - the tuple's location_2=-1 for vertex collision.
+  Note - time is swept once and agents are hashed by their cell at each timestep, so only agents sharing
+         a cell (or a cell and its swapped edge) are compared. That is O(agents * T) instead of O(agents^2 * T).
+  Note - a pair only collides before the later of its two paths ends.
+  Note - with a window, collisions after timestep window are ignored (they are resolved by a later replan).
+  Note - used for the root only, other nodes update their parent's collisions (see updateCollisions).
  */
 vector< tuple<int, int, int, int, int> >* ECBSSearch::extractCollisions() {
   vector< tuple<int, int, int, int, int> >* cons_found = new vector< tuple<int, int, int, int, int> >();
-  earliest_conflict = make_tuple(-1, -1, -1, -1, INT_MAX);
-  for (int a1 = 0; a1 < num_of_agents; a1++) {
-    for (int a2 = a1+1; a2 < num_of_agents; a2++) {
-      size_t max_path_length = paths[a1].size() > paths[a2].size() ? paths[a1].size() : paths[a2].size();
-      for (size_t timestep = 0; timestep < max_path_length; timestep++) {
-        if ( getAgentLocation(a1, timestep) == getAgentLocation(a2, timestep) ) {
-          cons_found->push_back(make_tuple(a1,
-                                           a2,
-                                           getAgentLocation(a1, timestep),
-                                           -1,  // vertex collision (hence loc2=-1)
-                                           timestep) );
-          if ((int)timestep < std::get<4>(earliest_conflict))
-            earliest_conflict = make_tuple(a1, a2, getAgentLocation(a1, timestep), -1, timestep);
-        }
-        if ( switchedLocations(a1, a2, timestep) ) {
-          cons_found->push_back(make_tuple(a1,
-                                           a2,
-                                           getAgentLocation(a1, timestep),
-                                           getAgentLocation(a2, timestep),
-                                           timestep) );
-          if ((int)timestep < std::get<4>(earliest_conflict))
-            earliest_conflict = make_tuple(a1, a2, getAgentLocation(a1, timestep), getAgentLocation(a2, timestep), timestep);
-        }
+  size_t max_path_length = getPathsMaxLength();
+  if (window > 0 && window + 1 < max_path_length)
+    max_path_length = window + 1;
+  for (size_t timestep = 0; timestep < max_path_length; timestep++) {
+    // hash agents by cell (in increasing id order, so each bucket is sorted)
+    for (int ag = num_of_agents-1; ag >= 0; ag--) {
+      int loc = getAgentLocation(ag, timestep);
+      next_in_cell[ag] = cell_head[loc];
+      cell_head[loc] = ag;
+    }
+    for (int a1 = 0; a1 < num_of_agents; a1++) {
+      int loc1 = getAgentLocation(a1, timestep);
+      int next_loc1 = getAgentLocation(a1, timestep+1);
+      // vertex collisions with agents in the same cell
+      for (int a2 = next_in_cell[a1]; a2 != -1; a2 = next_in_cell[a2]) {
+        if ( timestep >= paths[a1].size() && timestep >= paths[a2].size() )
+          continue;  // both agents are done moving
+        cons_found->push_back(make_tuple(a1, a2, loc1, -1, timestep));  // vertex collision (hence loc2=-1)
+      }
+      // edge collisions with agents in the cell a1 moves to, that move to a1's cell
+      for (int a2 = cell_head[next_loc1]; a2 != -1; a2 = next_in_cell[a2]) {
+        if ( a2 <= a1 || getAgentLocation(a2, timestep+1) != loc1 || !switchedLocations(a1, a2, timestep) )
+          continue;
+        cons_found->push_back(make_tuple(a1, a2, loc1, next_loc1, timestep));
       }
     }
+    for (int ag = 0; ag < num_of_agents; ag++)
+      cell_head[getAgentLocation(ag, timestep)] = -1;
   }
   return cons_found;
 }
+
+/*
+  Appends the collisions of agent_id moving along path with all other agents (on their current paths).
+  Note - tuples are ordered as in extractCollisions (agent1_id < agent2_id, location1 is agent1_id's).
+ */
+void ECBSSearch::findCollisions(int agent_id, const vector<int>& path, vector< tuple<int, int, int, int, int> >* cons_found) {
+  for (int ag = 0; ag < num_of_agents; ag++) {
+    if (ag == agent_id)
+      continue;
+    size_t max_path_length = path.size() > paths[ag].size() ? path.size() : paths[ag].size();
+    if (window > 0 && window + 1 < max_path_length)
+      max_path_length = window + 1;
+    for (size_t timestep = 0; timestep < max_path_length; timestep++) {
+      int loc = timestep < path.size() ? path[timestep] : path.back();
+      int next_loc = timestep + 1 < path.size() ? path[timestep+1] : path.back();
+      int other_loc = getAgentLocation(ag, timestep);
+      if ( loc == other_loc )
+        cons_found->push_back(make_tuple(min(ag, agent_id), max(ag, agent_id), loc, -1, timestep));
+      if ( loc == getAgentLocation(ag, timestep+1) && next_loc == other_loc ) {
+        if (agent_id < ag)
+          cons_found->push_back(make_tuple(agent_id, ag, loc, other_loc, timestep));
+        else
+          cons_found->push_back(make_tuple(ag, agent_id, other_loc, loc, timestep));
+      }
+    }
+  }
+}
+
+// child's collisions are its parent's, but those of the replanned agent are recomputed with its new path
+// Note -- paths must hold the parent's paths
+inline void ECBSSearch::updateCollisions(ECBSNode* child, const ECBSNode* parent) {
+  child->collisions.clear();
+  for (size_t i = 0; i < parent->collisions.size(); i++)
+    if ( get<0>(parent->collisions[i]) != child->agent_id && get<1>(parent->collisions[i]) != child->agent_id )
+      child->collisions.push_back(parent->collisions[i]);
+  findCollisions(child->agent_id, child->path, &child->collisions);
+}
+
+// the earliest conflict is the first one of the smallest timestep in (agent1_id, agent2_id, vertex before edge) order
+void ECBSSearch::updateEarliestConflict(const vector< tuple<int, int, int, int, int> >& collisions) {
+  earliest_conflict = make_tuple(-1, -1, -1, -1, INT_MAX);
+  for (size_t i = 0; i < collisions.size(); i++) {
+    const tuple<int, int, int, int, int>& c = collisions[i];
+    if ( make_tuple(get<4>(c), get<0>(c), get<1>(c), get<3>(c) != -1) <
+         make_tuple(get<4>(earliest_conflict), get<0>(earliest_conflict), get<1>(earliest_conflict), get<3>(earliest_conflict) != -1) )
+      earliest_conflict = c;
+  }
+}
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Returns the maximal path length (among all agent)
@@ -285,41 +343,17 @@ size_t ECBSSearch::getPathsMaxLength() {
   return retVal;
 }
 
-// Generates a boolean reservation table for paths (cube of map_size*max_timestep).
-// This is used by the low-level ECBS to count possible collisions efficiently
-// Note -- we do not include the agent for which we are about to plan for
-void ECBSSearch::updateReservationTable(bool* res_table, size_t max_path_len, int exclude_agent) {
-  for (int ag = 0; ag < num_of_agents; ag++) {
-    if (ag != exclude_agent && !paths[ag].empty()) {
-      for (size_t timestep = 0; timestep < max_path_len; timestep++) {
-        int id = getAgentLocation(ag, timestep);
-        res_table[id + timestep*map_size] = true;
-      }
-    }
-  }
-}
-
 // Compute the number of pairs of agents colliding (h_3 in ECBS's paper)
-int ECBSSearch::computeNumOfCollidingAgents() {
-  //  cout << "   *-*-* Computed number of colliding agents: " << endl;
+// (each agent is counted once if it collides with any agent of a larger id)
+int ECBSSearch::computeNumOfCollidingAgents(const vector< tuple<int, int, int, int, int> >& collisions) {
+  vector<bool> colliding(num_of_agents, false);
   int retVal = 0;
-  for (int a1 = 0; a1 < num_of_agents; a1++) {
-    for (int a2 = a1+1; a2 < num_of_agents; a2++) {
-      size_t max_path_length = paths[a1].size() > paths[a2].size() ? paths[a1].size() : paths[a2].size();
-      for (size_t timestep = 0; timestep < max_path_length; timestep++) {
-        //        cout << "   A1:" << getAgentLocation(a1, timestep) << ", A2:" <<  getAgentLocation(a2, timestep) << ", T:" << timestep;
-        if ( getAgentLocation(a1, timestep) == getAgentLocation(a2, timestep) ||
-             switchedLocations(a1, a2, timestep) ) {
-          retVal++;
-          // break to the outer (a1) loop
-          timestep = max_path_length;
-          a2 = num_of_agents;
-          //          cout << " !BOOM! ";
-        }
-      }
+  for (size_t i = 0; i < collisions.size(); i++) {
+    if ( !colliding[get<0>(collisions[i])] ) {
+      colliding[get<0>(collisions[i])] = true;
+      retVal++;
     }
   }
-  //  cout << "   *-*-* Computed number of colliding agents returns: " << retVal << endl;
   return retVal;
 }
 
@@ -328,22 +362,29 @@ int ECBSSearch::computeNumOfCollidingAgents() {
 //	:cons_paths(cons_paths), num_expanded(0), curr_time(curr_time), agents(agents)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const vector<vector<int> > &cons_paths, 
-						int curr_time, int col, double f_w)
-	:cons_paths(cons_paths), curr_time(curr_time), agents(agents), focal_w(f_w),
+						int curr_time, int col, double f_w, int window, const vector<vector<int> >* warm_paths)
+	:curr_time(curr_time), window(window), agents(agents), focal_w(f_w),
 	HL_num_expanded(0), HL_num_generated(0), LL_num_expanded(0), LL_num_generated(0),
-	solution_found(false), solution_cost(-1)
+	solution_found(false), solution_cost(-1), timed_out(false), root_failed(false)
 {
 
   num_of_agents = agents.size();
   map_size = my_map.size();
+  cell_head = vector <int> (map_size, -1);
+  next_in_cell = vector <int> (num_of_agents, -1);
  
   ll_min_f_vals = vector <double> (num_of_agents);
   paths_costs = vector <double> (num_of_agents);
   ll_min_f_vals_found_initially = vector <double> (num_of_agents);
   paths_costs_found_initially = vector <double> (num_of_agents);
   search_engines = vector < SingleAgentECBS* > (num_of_agents);
+  res_table = new ReservationTable(map_size, num_of_agents);
+  // the paths of DELIVER agents are fixed during the search, so they are hashed once and shared by all search_engines
+  cons_paths_table = new ConstraintTable(map_size);
+  for (size_t i = 0; i < cons_paths.size(); i++)
+	  cons_paths_table->addPath(cons_paths[i], curr_time);
   for (int i = 0; i < num_of_agents; i++) {
-	  search_engines[i] = new SingleAgentECBS(cons_paths, agents[i]->next_ep->h_val, my_map,
+	  search_engines[i] = new SingleAgentECBS(cons_paths_table, agents[i]->next_ep->h_val, my_map,
 		  agents[i]->id, agents[i]->loc, agents[i]->next_ep->loc, col, curr_time, agents[0]->path.size());
   }
 
@@ -360,44 +401,66 @@ ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const
   for (int ag = 0; ag < num_of_agents; ag++)
 	  paths_found_initially[ag].clear();
 
-  // initialize paths_found_initially
+  // initialize paths_found_initially (each agent avoids the paths of the agents before it)
+  paths = paths_found_initially;
+  // warm start -- previous paths that are still valid are kept (and avoided by the agents searched below)
+  vector<bool> reused(num_of_agents, false);
+  if (warm_paths != NULL) {
+    for (int i = 0; i < num_of_agents; i++) {
+      if ( !search_engines[i]->reusePath(warm_paths->at(i), f_w) )
+        continue;
+      reused[i] = true;
+      paths_found_initially[i] = search_engines[i]->path;
+      paths[i] = paths_found_initially[i];
+      res_table->setPath(i, paths[i]);
+      ll_min_f_vals_found_initially[i] = search_engines[i]->min_f_val;
+      paths_costs_found_initially[i] = search_engines[i]->path_cost;
+    }
+  }
   for (int i = 0; i < num_of_agents; i++) {
+    if (reused[i])
+      continue;
     //    cout << "Computing initial path for agent " << i << endl; fflush(stdout);
-    paths = paths_found_initially;
     size_t max_plan_len = getPathsMaxLength();
-    bool* res_table = new bool[map_size * max_plan_len]();  // initialized to false
-    updateReservationTable(res_table, max_plan_len, i);
-    //    cout << "*** CALCULATING INIT PATH FOR AGENT " << i << ". Reservation Table[MAP_SIZE x MAX_PLAN_LEN]: " << endl;
-    //    printResTable(res_table, max_plan_len);
-    if ( search_engines[i]->findPath ( f_w, NULL, res_table, max_plan_len ) == false)
+    if ( search_engines[i]->findPath ( f_w, NULL, res_table, max_plan_len, i ) == false) {
       cout << "NO SOLUTION EXISTS";
+      root_failed = true;
+      search_engines[i]->path = vector<int>(1, agents[i]->loc);  // keeps paths well defined (runECBSSearch fails right away)
+    }
     paths_found_initially[i] = search_engines[i]->path;
+    paths[i] = paths_found_initially[i];
+    res_table->setPath(i, paths[i]);
     ll_min_f_vals_found_initially[i] = search_engines[i]->min_f_val;
     paths_costs_found_initially[i] = search_engines[i]->path_cost;
     LL_num_expanded += search_engines[i]->num_expanded;
     LL_num_generated += search_engines[i]->num_generated;
-    delete[] res_table;
     //    cout << endl;
   }
 
-  paths = paths_found_initially;
   ll_min_f_vals = ll_min_f_vals_found_initially;
   paths_costs = paths_costs_found_initially;
 
   // generate dummy start and update data structures
-  dummy_start = new ECBSNode();
+  dummy_start = node_pool.create();
   dummy_start->agent_id = -1;
   dummy_start->g_val = 0;
   for (int i = 0; i < num_of_agents; i++)
     dummy_start->g_val += paths_costs[i];
   dummy_start->ll_min_f_val = 0;
   dummy_start->sum_min_f_vals = compute_hl_lower_bound();
+  vector< tuple<int, int, int, int, int> >* collision_vec = extractCollisions();
+  dummy_start->collisions.swap(*collision_vec);
+  delete (collision_vec);
   dummy_start->open_handle = open_list.push(dummy_start);
   dummy_start->focal_handle = focal_list.push(dummy_start);
   HL_num_generated++;
   dummy_start->time_generated = HL_num_generated;
   allNodes_table[dummy_start] = dummy_start;
+  paths_node = dummy_start;
+  agent_nodes = vector < ECBSNode* > (num_of_agents, NULL);
 
+  best_node = dummy_start;
+  best_num_collisions = dummy_start->collisions.size();
   min_sum_f_vals = dummy_start->sum_min_f_vals;
   focal_list_threshold = focal_w * dummy_start->sum_min_f_vals;
 
@@ -412,6 +475,14 @@ bool ECBSSearch::runECBSSearch() {
   std::clock_t start;
   double duration;
   start = std::clock();
+  std::chrono::steady_clock::time_point budget_start = std::chrono::steady_clock::now();
+  if (root_failed)
+    return false;
+  if (parallel_children) {
+    child_job = NULL;
+    child_stop = false;
+    child_worker = thread(&ECBSSearch::replanChildren, this);
+  }
 
   // start is already in the open_list
   while ( !focal_list.empty() && !solution_found ) {
@@ -421,7 +492,14 @@ bool ECBSSearch::runECBSSearch() {
       cout << "TIMEOUT  ; " << solution_cost << " ; " << min_sum_f_vals << " ; " <<
           HL_num_expanded << " ; " << HL_num_generated << " ; " <<
           LL_num_expanded << " ; " << LL_num_generated << " ; " << duration << endl;
-      return false;
+      timed_out = true;
+      break;
+    }
+    // stop (with the best node found so far) once the wall-clock budget is used up
+    if (time_budget > 0 &&
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - budget_start).count() > time_budget) {
+      timed_out = true;
+      break;
     }
 
     ECBSNode* curr = focal_list.top();
@@ -432,10 +510,11 @@ bool ECBSSearch::runECBSSearch() {
     //    cout << "Expanding: (" << curr << ")" << *curr << " at time:" << HL_num_expanded << endl;
 
     // takes the paths_found_initially and UPDATE all constrained paths found for agents from curr to dummy_start (and lower-bounds)
-    updatePaths(curr, dummy_start);
+    updatePaths(curr);
     //    printPaths();
 
-    vector< tuple<int, int, int, int, int> >* collision_vec = extractCollisions();  // check for collisions on updated paths
+    vector< tuple<int, int, int, int, int> >* collision_vec = &curr->collisions;  // collisions on updated paths (found when curr was generated)
+    updateEarliestConflict(*collision_vec);
 #ifndef NDEBUG
     cout << endl << "****** Expanded #" << curr->time_expanded << " with cost " << curr->g_val << " and # Collisions " << collision_vec->size() << " and |FOCAL|=" << focal_list.size() << " and focal-threshold=" << focal_list_threshold << endl;
 #endif
@@ -456,8 +535,8 @@ bool ECBSSearch::runECBSSearch() {
       cout << "   Earliest collision -- A1:" << agent1_id << " ; A2: " << agent2_id
 	   << " ; L1:" << location1 << " ; L2:" << location2 << " ; T:" << timestep << endl;
 #endif
-      ECBSNode* n1 = new ECBSNode();
-      ECBSNode* n2 = new ECBSNode();
+      ECBSNode* n1 = node_pool.create();
+      ECBSNode* n2 = node_pool.create();
       n1->agent_id = agent1_id;
       n2->agent_id = agent2_id;
       if (location2 == -1) {  // generate vertex constraint
@@ -469,16 +548,41 @@ bool ECBSSearch::runECBSSearch() {
       }
       n1->parent = curr;
       n2->parent = curr;
+      n1->depth = n2->depth = curr->depth + 1;
+      n1->agent_parent = agent_nodes[agent1_id];  // agent_nodes hold curr's branch (see updatePaths)
+      n2->agent_parent = agent_nodes[agent2_id];
       //      cout << "*** Before solving, " << endl << *n1;
-      // find all constraints on this agent (recursing to the root) and compute (and store) a path satisfying them. Also updates n1's g_val
-      if ( updateECBSNode(n1, dummy_start) == true ) {
+      // find all constraints on each agent and compute (and store) a path satisfying them.
+      // the two agents have their own search engines, so with parallel_children n2's search runs on child_worker
+      // (the result does not depend on it -- both searches only read curr's paths)
+      bool n1_found, n2_found;
+      if (parallel_children) {
+        {
+          std::lock_guard<std::mutex> lock(child_mutex);
+          child_job = n2;
+        }
+        child_cv.notify_one();
+        n1_found = updateECBSNode(n1);
+        std::unique_lock<std::mutex> lock(child_mutex);
+        child_cv.wait(lock, [this]() { return child_job == NULL; });
+        n2_found = child_found;
+      } else {
+        n1_found = updateECBSNode(n1);
+        n2_found = updateECBSNode(n2);
+      }
+      LL_num_expanded += search_engines[agent1_id]->num_expanded + search_engines[agent2_id]->num_expanded;
+      LL_num_generated += search_engines[agent1_id]->num_generated + search_engines[agent2_id]->num_generated;
+
+#ifndef NDEBUG
+      cout << "Run search for AG" << agent1_id << " ; found solution? " << std::boolalpha << n1_found;
+#endif
+      // Also updates n1's g_val
+      if ( n1_found ) {
         // new g_val equals old g_val plus the new path length found for the agent minus its old path length
         n1->g_val = curr->g_val - paths_costs[n1->agent_id] + n1->path_cost;
-        // update n1's path for computing the num of colliding agents
-        vector<int> temp_old_path = paths[n1->agent_id];
-        paths[n1->agent_id] = (n1->path);
-        n1->h_val = computeNumOfCollidingAgents();
-        paths[n1->agent_id] = temp_old_path;  // restore the old path (for n2)
+        // paths still hold curr's paths, so only the collisions of n1's agent are recomputed
+        updateCollisions(n1, curr);
+        n1->h_val = computeNumOfCollidingAgents(n1->collisions);
         // update lower bounds and handles
         n1->sum_min_f_vals = curr->sum_min_f_vals - ll_min_f_vals[n1->agent_id] + n1->ll_min_f_val;
         n1->open_handle = open_list.push(n1);
@@ -486,33 +590,36 @@ bool ECBSSearch::runECBSSearch() {
         n1->time_generated = HL_num_generated;
         if ( n1->sum_min_f_vals <= focal_list_threshold )
           n1->focal_handle = focal_list.push(n1);
+        else
+          open_above_focal.insert(std::make_pair(n1->sum_min_f_vals, n1));
         allNodes_table[n1] = n1;
+        updateBestNode(n1);
 #ifndef NDEBUG
 	cout << endl << "   First node generated for A" << n1->agent_id << ": g-val=" << n1->g_val << " ; h-val=" << n1->h_val << " ; LB=" << n1->sum_min_f_vals << endl;
 #endif
-      } else {
-        delete (n1);
-      }
+      }  // otherwise n1 is left unused in node_pool
       // same for n2
       //      cout << "*** Before solving, " << endl << *n2;
-      if ( updateECBSNode(n2, dummy_start) == true ) {
+#ifndef NDEBUG
+      cout << "Run search for AG" << agent2_id << " ; found solution? " << std::boolalpha << n2_found;
+#endif
+      if ( n2_found ) {
         n2->g_val = curr->g_val - paths_costs[n2->agent_id] + n2->path_cost;
-        vector<int> temp_old_path = paths[n2->agent_id];
-        paths[n2->agent_id] = (n2->path);
-        n2->h_val = computeNumOfCollidingAgents();
-        paths[n2->agent_id] = temp_old_path;
+        updateCollisions(n2, curr);
+        n2->h_val = computeNumOfCollidingAgents(n2->collisions);
         n2->sum_min_f_vals = curr->sum_min_f_vals - ll_min_f_vals[n2->agent_id] + n2->ll_min_f_val;
         n2->open_handle = open_list.push(n2);
         HL_num_generated++;
         n2->time_generated = HL_num_generated;
         if ( n2->sum_min_f_vals <= focal_list_threshold )
           n2->focal_handle = focal_list.push(n2);
+        else
+          open_above_focal.insert(std::make_pair(n2->sum_min_f_vals, n2));
         allNodes_table[n2] = n2;
+        updateBestNode(n2);
 #ifndef NDEBUG
 	cout << endl << "   Second node generated for A" << n2->agent_id << ": g-val=" << n2->g_val << " ; h-val=" << n2->h_val << " ; LB=" << n2->sum_min_f_vals << endl;
 #endif
-      } else {
-        delete (n2);
       }
       //            cout << "It has found the following paths:" << endl;
       //            printPaths();
@@ -534,8 +641,21 @@ bool ECBSSearch::runECBSSearch() {
       }
       //            cout << " ; (after) " << focal_list_threshold << endl << endl;
     }  // end generating successors
-    delete (collision_vec);
+    if (!solution_found)
+      vector< tuple<int, int, int, int, int> >().swap(curr->collisions);  // no longer needed once the children have them
   }  // end of while loop
+  if (child_worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(child_mutex);
+      child_stop = true;
+    }
+    child_cv.notify_one();
+    child_worker.join();
+  }
+
+  // without a solution, paths hold the best (fewest collisions) node generated
+  if (!solution_found)
+    updatePaths(best_node);
 
   // get time
   duration = (std::clock() - start) / (double) CLOCKS_PER_SEC;
@@ -554,7 +674,115 @@ bool ECBSSearch::runECBSSearch() {
 }
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// keeps the generated node with the fewest collisions (the earliest one on ties)
+inline void ECBSSearch::updateBestNode(ECBSNode* node) {
+  if (node->collisions.size() < best_num_collisions) {
+    best_node = node;
+    best_num_collisions = node->collisions.size();
+  }
+}
+
+
+// Prioritized planning: plans the agents in order, each treating the paths of the agents not in order and of the
+// agents planned before it as hard constraints. An agent that finds no path is moved to the front of the order and
+// the planning restarts (once per agent).
+// returns true (and the paths of the agents in order in new_paths) if all of them found a path, false otherwise.
+bool ECBSSearch::planInOrder(list<int>& order, vector< vector<int> >& new_paths) {
+  vector<bool> replanned(num_of_agents, false);
+  for (list<int>::iterator it = order.begin(); it != order.end(); it++)
+    replanned[*it] = true;
+  vector<bool> promoted(num_of_agents, false);
+  while (true) {
+    ConstraintTable fixed_paths(map_size);
+    for (int ag = 0; ag < num_of_agents; ag++)
+      if (!replanned[ag])
+        fixed_paths.addPath(paths[ag], 0);
+    int failed = -1;
+    for (list<int>::iterator it = order.begin(); it != order.end(); it++) {
+      bool foundSol = search_engines[*it]->findPath(focal_w, &fixed_paths, NULL, 0, *it);
+      LL_num_expanded += search_engines[*it]->num_expanded;
+      LL_num_generated += search_engines[*it]->num_generated;
+      if (!foundSol) {
+        failed = *it;
+        break;
+      }
+      new_paths[*it] = search_engines[*it]->path;
+      fixed_paths.addPath(new_paths[*it], 0);
+    }
+    if (failed == -1)
+      break;
+    if (promoted[failed])
+      return false;
+    promoted[failed] = true;
+    order.remove(failed);
+    order.push_front(failed);
+  }
+  return true;
+}
+
+
+// Fallback for when runECBSSearch stops without a solution: keeps the paths (of the best node) that do not collide,
+// and replans the colliding agents with prioritized planning.
+// returns true if all of them found a path (then paths are collision free), false otherwise (paths unchanged).
+bool ECBSSearch::repairPaths() {
+  if (root_failed)
+    return false;
+  vector<bool> colliding(num_of_agents, false);
+  vector< tuple<int, int, int, int, int> >* collision_vec = extractCollisions();
+  for (size_t i = 0; i < collision_vec->size(); i++) {
+    colliding[get<0>(collision_vec->at(i))] = true;
+    colliding[get<1>(collision_vec->at(i))] = true;
+  }
+  delete (collision_vec);
+
+  list<int> order;  // colliding agents, in planning order
+  for (int ag = 0; ag < num_of_agents; ag++)
+    if (colliding[ag])
+      order.push_back(ag);
+  vector < vector<int> > new_paths(num_of_agents);
+  if (!planInOrder(order, new_paths))
+    return false;
+  for (list<int>::iterator it = order.begin(); it != order.end(); it++) {
+    paths[*it] = new_paths[*it];
+    paths_costs[*it] = new_paths[*it].size() - 1;
+  }
+  return true;
+}
+
+
+// Fast path before runECBSSearch: plans all the agents with prioritized planning (in agent order).
+// The result is kept only if its cost is within focal_w of the root's lower bound, the bound runECBSSearch
+// guarantees as well. returns true if so (then paths are collision free), false otherwise (paths unchanged).
+bool ECBSSearch::runPrioritizedSearch() {
+  if (root_failed)
+    return false;
+  list<int> order;
+  for (int ag = 0; ag < num_of_agents; ag++)
+    order.push_back(ag);
+  vector < vector<int> > new_paths(num_of_agents);
+  if (!planInOrder(order, new_paths))
+    return false;
+  double cost = 0;
+  for (int ag = 0; ag < num_of_agents; ag++)
+    cost += new_paths[ag].size() - 1;
+  if (cost > focal_list_threshold)
+    return false;
+  for (int ag = 0; ag < num_of_agents; ag++) {
+    paths[ag] = new_paths[ag];
+    paths_costs[ag] = new_paths[ag].size() - 1;
+  }
+  solution_found = true;
+  solution_cost = cost;
+  return true;
+}
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 ECBSSearch::~ECBSSearch() {
   for (size_t i = 0; i < search_engines.size(); i++)
     delete (search_engines[i]);
+  delete (res_table);
+  delete (cons_paths_table);
+  releaseClosedListNodes();
+  delete (empty_node);
+  delete (deleted_node);
 }
@@ -12,10 +12,15 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "Agent.h"
 #include "single_agent_ecbs.h"
 #include "ecbs_node.h"
+#include "node_pool.h"
 
 using boost::heap::fibonacci_heap;
 using boost::heap::compare;
@@ -26,6 +31,8 @@ using google::dense_hash_map;
 class ECBSSearch {
  public:
   double focal_w = 1.0;
+  bool parallel_children = false;  // replan the two children of an expanded node on two threads (same result as sequential)
+  double time_budget = 0;  // wall-clock seconds for runECBSSearch, 0 means no limit
   double focal_list_threshold;
   double min_sum_f_vals;
 
@@ -38,6 +45,8 @@ class ECBSSearch {
 
   bool solution_found;
   double solution_cost;
+  bool timed_out;  // runECBSSearch stopped because of a time limit
+  bool root_failed;  // some agent has no path even without constraints (then there is no solution)
 
   ECBSNode* dummy_start;
   vector <int> start_locations;
@@ -57,49 +66,75 @@ class ECBSSearch {
 
   heap_open_t open_list;
   heap_focal_t focal_list;
+  std::multimap<double, ECBSNode*> open_above_focal;  // OPEN nodes above focal_list_threshold, by sum_min_f_vals
   hashtable_t allNodes_table;
+  NodePool<ECBSNode> node_pool;  // all the high-level nodes (released in bulk by releaseClosedListNodes)
 
   // used in hash table and would be deleted from the d'tor
   ECBSNode* empty_node;
   ECBSNode* deleted_node;
 
+  ECBSNode* best_node;  // the generated node with the fewest collisions (paths hold it if the search fails)
+  size_t best_num_collisions;
+  ECBSNode* paths_node;  // the node whose solution is currently held by paths
+  vector < ECBSNode* > agent_nodes;  // [i] is the youngest node on the branch of paths_node constraining agent i (NULL if none)
+
   vector < SingleAgentECBS* > search_engines;  // used to find (single) agents' paths
+  ReservationTable* res_table;  // reservations of paths, used by search_engines to count conflicts
   vector <double> ll_min_f_vals_found_initially;  // contains initial ll_min_f_vals found
   vector <double> ll_min_f_vals;  // each entry [i] represent the lower bound found for agent[i]
   vector <double> paths_costs_found_initially;
   vector <double> paths_costs;
 
-  tuple<int, int, int, int, int> earliest_conflict;  // saves the earliest conflict (updated in every call to extractCollisions()).
+  tuple<int, int, int, int, int> earliest_conflict;  // saves the earliest conflict (updated in every call to updateEarliestConflict()).
 
   ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const vector<vector<int> > &cons_paths,
-	  int curr_time, int col, double f_w);
+	  int curr_time, int col, double f_w, int window = 0, const vector<vector<int> >* warm_paths = NULL);
   inline double compute_g_val();
   inline double compute_hl_lower_bound();
-  inline void updatePaths(ECBSNode* curr , ECBSNode* root_node);
-  inline bool updateECBSNode(ECBSNode* leaf_node, ECBSNode* root_node);
+  inline void updatePaths(ECBSNode* curr);
+  inline bool updateECBSNode(ECBSNode* leaf_node);
   bool runECBSSearch();
   inline bool switchedLocations(int agent1_id, int agent2_id, size_t timestep);
   inline int getAgentLocation(int agent_id, size_t timestep);
   vector< tuple<int, int, int, int, int> >* extractCollisions();
+  void findCollisions(int agent_id, const vector<int>& path, vector< tuple<int, int, int, int, int> >* cons_found);
+  inline void updateCollisions(ECBSNode* child, const ECBSNode* parent);
+  void updateEarliestConflict(const vector< tuple<int, int, int, int, int> >& collisions);
   void printPaths();
-  void printResTable(bool* res_table, size_t max_plan_len);
   void updatePathsForExpTime(int t_exp);
 
   size_t getPathsMaxLength();
-  void updateReservationTable(bool* res_table, size_t max_plan_len, int exclude_agent);
+  inline void updateBestNode(ECBSNode* node);
+  bool planInOrder(list<int>& order, vector< vector<int> >& new_paths);
+  bool repairPaths();
+  bool runPrioritizedSearch();
 
   void updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight);
 
-  int computeNumOfCollidingAgents();
+  int computeNumOfCollidingAgents(const vector< tuple<int, int, int, int, int> >& collisions);
 
   inline void releaseClosedListNodes();
 
   ~ECBSSearch();
 
 private:
+	vector <int> cell_head;  // [loc] is the first agent in loc at the swept timestep (-1 if none), used by extractCollisions()
+	vector <int> next_in_cell;  // [i] is the next agent in the same cell as agent i
 	int curr_time;
-	const vector<vector<int> > cons_paths;
+	size_t window;  // only collisions up to this timestep (from curr_time) are resolved, 0 for all
+	ConstraintTable* cons_paths_table;  // constraints from the paths of DELIVER agents, shared by search_engines
 	vector<Agent*> agents;
+
+	// with parallel_children, runECBSSearch starts child_worker once and hands it the second child of every expansion.
+	// it replans with the child's agent's own search engine and constraint table, like updateECBSNode on this thread
+	std::thread child_worker;
+	std::mutex child_mutex;
+	std::condition_variable child_cv;
+	ECBSNode* child_job;  // the child child_worker replans (NULL when there is none)
+	bool child_found;  // updateECBSNode's result for the last child_job
+	bool child_stop;  // tells child_worker to return
+	void replanChildren();  // child_worker's loop
 };
 
 #endif
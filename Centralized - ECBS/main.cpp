@@ -1,18 +1,128 @@
 #include <iostream>
+#include <sstream>
 #include "Simulation.h"
 
+#include <boost/program_options.hpp>
+
 using namespace std;
 
-void main(int argc, char** argv)
+int main(int argc, char** argv)
 {
+	namespace po = boost::program_options;
+	po::options_description desc("Allowed options");
+	desc.add_options()
+		("help,h", "produce help message")
+		("map,m", po::value<string>(), "input file for map")
+		("task,t", po::value<string>(), "input file for tasks")
+		("focal-weight,w", po::value<double>()->default_value(1.0), "focal weight")
+		("output,o", po::value<vector<string> >()->multitoken(), "outputs to write: throughput task path none (default throughput task)")
+		("time-limit,l", po::value<double>()->default_value(0), "wall-clock seconds for the run, 0 for no limit")
+		("latency,L", po::value<double>()->default_value(0), "tune the focal weight every timestep so planning takes about this many wall-clock seconds (the focal weight is the lower limit), 0 for a fixed weight")
+		("max-weight", po::value<double>()->default_value(2.0), "upper limit of the tuned focal weight")
+		("budget,b", po::value<double>()->default_value(0), "wall-clock seconds for each ECBS search before falling back to the best paths found, 0 for no limit")
+		("window,W", po::value<int>()->default_value(0), "rolling horizon: resolve collisions only within this many timesteps, 0 for whole paths")
+		("replan,H", po::value<int>(), "with a window, replan package agents every this many timesteps (default: the window)")
+		("warm-start,s", "start each ECBS search from the previous paths that are still valid")
+		("candidates,k", po::value<int>()->default_value(-1), "task assignment searches paths to the k nearest starts of each agent and uses BFS distances for the rest, -1 for all")
+		("threads,j", po::value<unsigned int>()->default_value(1), "threads computing the task assignment cost matrix (same results)")
+		("batch,B", "plan all agents that need new paths in a single ECBS search per timestep")
+		("skip-idle,I", "skip planning at timesteps where no task appears or finishes and no agent picks one up")
+		("events,E", "event-driven clock: only simulate timesteps where tasks appear, agents reach their goals or are due for replanning")
+		("verify,V", po::value<string>()->default_value("full"), "collision test of the paths after each timestep: full (every pair of agents), incremental (only new paths, against an index) or off")
+		("verify-every", po::value<int>()->default_value(1), "run the collision test only every this many timesteps")
+		("auction,a", "task assignment by a sparse auction over the candidate starts (see -k), warm-started from the previous timestep")
+		("prioritized,P", "try prioritized planning first and run ECBS only if it fails or costs more than the focal weight allows")
+		("parallel,p", "replan the two children of each high-level ECBS node in parallel (same results)")
+	;
+	po::positional_options_description pos;
+	pos.add("map", 1).add("task", 1);
+
+	po::variables_map vm;
+	try
+	{
+		po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+		po::notify(vm);
+	}
+	catch (const po::error &e)
+	{
+		cerr << e.what() << endl << desc << endl;
+		return 1;
+	}
+	if (vm.count("help"))
+	{
+		cout << desc << endl;
+		return 0;
+	}
+	if (!vm.count("map") || !vm.count("task"))
+	{
+		cerr << "Usage: " << argv[0] << " MapFile TaskFile [options]" << endl << desc << endl;
+		return 1;
+	}
+	string map_name = vm["map"].as<string>();
+	string task_name = vm["task"].as<string>();
+
+	bool save_throughput = !vm.count("output"), save_task = !vm.count("output"), save_path = false;
+	if (vm.count("output"))
+	{
+		vector<string> outputs = vm["output"].as<vector<string> >();
+		for (unsigned int i = 0; i < outputs.size(); i++)
+		{
+			if (outputs[i] == "throughput") save_throughput = true;
+			else if (outputs[i] == "task") save_task = true;
+			else if (outputs[i] == "path") save_path = true;
+			else if (outputs[i] != "none")
+			{
+				cerr << "Unknown output " << outputs[i] << endl;
+				return 1;
+			}
+		}
+	}
+
 	//Simulation simu("kiva-150-1500-100.map", "kiva-150-1500-100.task");
-	Simulation simu(argv[1], argv[2]);
-	int w = 1;
+	Simulation simu(map_name, task_name);
+	double w = vm["focal-weight"].as<double>();
+	simu.time_limit = vm["time-limit"].as<double>();
+	simu.parallel_children = vm.count("parallel") > 0;
+	simu.prioritized_first = vm.count("prioritized") > 0;
+	simu.warm_start = vm.count("warm-start") > 0;
+	simu.assign_candidates = vm["candidates"].as<int>();
+	simu.assign_threads = vm["threads"].as<unsigned int>();
+	simu.auction_assign = vm.count("auction") > 0;
+	simu.batch_planning = vm.count("batch") > 0;
+	simu.skip_idle = vm.count("skip-idle") > 0;
+	simu.event_driven = vm.count("events") > 0;
+	string verify = vm["verify"].as<string>();
+	if ((verify != "full" && verify != "incremental" && verify != "off") || vm["verify-every"].as<int>() < 1)
+	{
+		cerr << "The verify mode must be full, incremental or off, and verify-every at least 1" << endl;
+		return 1;
+	}
+	simu.verify_incremental = verify == "incremental";
+	simu.verify_period = verify == "off" ? 0 : vm["verify-every"].as<int>();
+	simu.plan_budget = vm["budget"].as<double>();
+	simu.latency_target = vm["latency"].as<double>();
+	simu.max_focal_w = vm["max-weight"].as<double>();
+	if (w < 1 || simu.latency_target < 0 || simu.max_focal_w < w)
+	{
+		cerr << "The focal weight must be at least 1, the latency >= 0 and the max weight at least the focal weight" << endl;
+		return 1;
+	}
+	simu.window = vm["window"].as<int>();
+	simu.replan_period = vm.count("replan") ? vm["replan"].as<int>() : simu.window;
+	if (simu.window < 0 || (simu.window > 0 && (simu.replan_period < 1 || simu.replan_period > simu.window)))
+	{
+		cerr << "The window must be >= 0 and the replan period between 1 and the window" << endl;
+		return 1;
+	}
 	simu.run(w);
-	simu.SaveThroughput((string)(argv[2]) + "ECBS_w" + to_string(w));
-	simu.SaveTask("ECBS_w" + to_string(w) + "_output.txt", argv[2]);
+
+	stringstream name;
+	name << "ECBS_w" << w;
+	if (simu.latency_target > 0) name << "_L" << simu.latency_target;
+	if (simu.window > 0) name << "_W" << simu.window << "_H" << simu.replan_period;
+	if (save_throughput) simu.SaveThroughput(task_name + name.str());
+	if (save_task) simu.SaveTask(name.str() + "_output.txt", task_name);
+	if (save_path) simu.SavePath(task_name + name.str() + ".path");
 	simu.ShowTask();
-	//simu.SaveTask("20analysis1_5.tsk");
-	//simu.SavePath("20analysis1_5.path");
-	return;
+	return 0;
 }
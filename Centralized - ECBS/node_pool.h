@@ -0,0 +1,53 @@
+// Region (arena) allocator for search nodes
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/* Constructs objects in large blocks instead of one heap allocation each.
+   Objects are never freed one by one -- clear() destroys all of them at once (when a search ends)
+   and keeps the blocks, so the next search reuses the same memory.
+ */
+template <class T>
+class NodePool {
+ public:
+  explicit NodePool(size_t block_size = 1024) : block_size(block_size), num_used(0) {}
+
+  template <class... Args>
+  T* create(Args&&... args) {
+    if (num_used == blocks.size() * block_size)
+      blocks.push_back(static_cast<T*>(::operator new(block_size * sizeof(T))));
+    T* obj = blocks[num_used / block_size] + num_used % block_size;
+    new (obj) T(std::forward<Args>(args)...);
+    num_used++;
+    return obj;
+  }
+
+  // destroys all the objects created so far
+  void clear() {
+    for (size_t i = 0; i < num_used; i++)
+      (blocks[i / block_size] + i % block_size)->~T();
+    num_used = 0;
+  }
+
+  size_t size() const { return num_used; }
+
+  ~NodePool() {
+    clear();
+    for (size_t i = 0; i < blocks.size(); i++)
+      ::operator delete(blocks[i]);
+  }
+
+ private:
+  std::vector<T*> blocks;
+  size_t block_size;  // number of objects per block
+  size_t num_used;
+
+  NodePool(const NodePool&);  // not copyable
+  NodePool& operator=(const NodePool&);
+};
+
+#endif
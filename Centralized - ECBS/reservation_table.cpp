@@ -0,0 +1,63 @@
+#include "reservation_table.h"
+#include <algorithm>
+
+
+ReservationTable::ReservationTable(int map_size, int num_of_agents) :
+    map_size(map_size), paths(num_of_agents) {
+  counts.set_empty_key(-1);
+  counts.set_deleted_key(-2);
+  goals.set_empty_key(-1);
+  goals.set_deleted_key(-2);
+}
+
+
+void ReservationTable::updateCounts(const vector<int>& path, int delta) {
+  for (size_t timestep = 0; timestep < path.size(); timestep++) {
+    int64_t key = path[timestep] + (int64_t)timestep * map_size;
+    int count = (counts[key] += delta);
+    if (count == 0)
+      counts.erase(key);
+  }
+}
+
+
+void ReservationTable::setPath(int agent_id, const vector<int>& path) {
+  vector<int>& old_path = paths[agent_id];
+  if (old_path == path)
+    return;
+  if (!old_path.empty()) {
+    updateCounts(old_path, -1);
+    vector<int>& holders = goals[old_path.back()];
+    holders.erase(std::find(holders.begin(), holders.end(), agent_id));
+    if (holders.empty())
+      goals.erase(old_path.back());
+  }
+  old_path = path;
+  if (!path.empty()) {
+    updateCounts(path, 1);
+    goals[path.back()].push_back(agent_id);
+  }
+}
+
+
+bool ReservationTable::isReserved(int loc, int timestep, int exclude_agent) const {
+  // agents that are still moving
+  dense_hash_map<int64_t, int>::const_iterator it = counts.find(loc + (int64_t)timestep * map_size);
+  if (it != counts.end()) {
+    int count = it->second;
+    if (exclude_agent >= 0 && (size_t)timestep < paths[exclude_agent].size() && paths[exclude_agent][timestep] == loc)
+      count--;
+    if (count > 0)
+      return true;
+  }
+  // agents that are done moving and wait at their last location
+  dense_hash_map<int, vector<int> >::const_iterator goal_it = goals.find(loc);
+  if (goal_it != goals.end()) {
+    for (size_t i = 0; i < goal_it->second.size(); i++) {
+      int ag = goal_it->second[i];
+      if (ag != exclude_agent && paths[ag].size() <= (size_t)timestep)
+        return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,40 @@
+// Sparse reservation table (location, timestep) -> number of agents
+#ifndef RESERVATIONTABLE_H
+#define RESERVATIONTABLE_H
+
+#include <stdint.h>
+#include <vector>
+#include <google/dense_hash_map>
+
+using std::vector;
+using google::dense_hash_map;
+
+/* Reservation table over the paths of all agents, used by the low-level ECBS to count conflicts.
+   Only the cells agents actually visit are stored, and an agent stays at its last location once its path ends
+   (as in ECBSSearch::getAgentLocation). Paths are set one agent at a time, so callers only apply the agents whose
+   path changed instead of rebuilding a map_size * max_plan_len cube for every search.
+ */
+class ReservationTable {
+ public:
+  ReservationTable(int map_size, int num_of_agents);
+
+  /* Replaces agent_id's path (an empty path removes it). Does nothing if the path did not change.
+   */
+  void setPath(int agent_id, const vector<int>& path);
+
+  /* Returns true if an agent other than exclude_agent (-1 for none) is at loc at timestep.
+   */
+  bool isReserved(int loc, int timestep, int exclude_agent) const;
+
+  ~ReservationTable() {}
+
+ private:
+  int map_size;
+  vector < vector<int> > paths;  // [i] is agent i's reserved path (empty if none)
+  dense_hash_map<int64_t, int> counts;  // loc + timestep*map_size -> number of agents there before their paths end
+  dense_hash_map<int, vector<int> > goals;  // loc -> agents whose paths end there
+
+  void updateCounts(const vector<int>& path, int delta);
+};
+
+#endif
@@ -16,9 +16,9 @@ using std::endl;
 using boost::heap::fibonacci_heap;
 
 
-SingleAgentECBS::SingleAgentECBS(const vector<vector<int> > &cons_paths, const vector<int> &my_heuristic, const vector<bool> &my_map,
+SingleAgentECBS::SingleAgentECBS(const ConstraintTable* cons_paths_table, const vector<int> &my_heuristic, const vector<bool> &my_map,
 	int ag_id, int start_location, int goal_location, int col, int curr_time, int max_time) :
-		cons_paths(cons_paths), my_heuristic(my_heuristic), my_map(my_map), ag_id(ag_id), start_location(start_location), goal_location(goal_location), curr_time(curr_time), 
+		cons_paths_table(cons_paths_table), my_heuristic(my_heuristic), my_map(my_map), ag_id(ag_id), start_location(start_location), goal_location(goal_location), curr_time(curr_time), 
 		num_expanded(0), num_generated(0), path_cost(0), lower_bound(0), min_f_val(0), num_non_hwy_edges(0), max_time(max_time)
 	{
  
@@ -30,6 +30,7 @@ SingleAgentECBS::SingleAgentECBS(const vector<vector<int> > &cons_paths, const v
   //deleted_node->loc = -2;
   //allNodes_table.set_empty_key(empty_node);
   //allNodes_table.set_deleted_key(deleted_node);
+  allNodes_table.set_empty_key(-1);
   actions_offset[0] = 0; actions_offset[1] = -col; actions_offset[2] = 1; actions_offset[3] = col; actions_offset[4] = -1; // [WAIT, NORTH, EAST, SOUTH, WEST]
 
 }
@@ -49,91 +50,58 @@ void SingleAgentECBS::updatePath(Node* goal) {
   path_cost = goal->g_val;
 }
 
-inline void SingleAgentECBS::releaseClosedListNodes(map<unsigned int, Node*> &allNodes_table) {
-   map<unsigned int, Node*>::iterator it;
-  for (it=allNodes_table.begin(); it != allNodes_table.end(); it++) {
-    delete ( (*it).second );  // Node* s = (*it).first; delete (s);
-  }
-  allNodes_table.clear();
+inline void SingleAgentECBS::releaseClosedListNodes() {
+  allNodes_table.clear_no_resize();  // keep the buckets for the next search
+  node_pool.clear();
 }
 
 
-// iterate over the constraints ( cons[t] is a list of all constraints for timestep t) and return the latest
-// timestep which has a constraint involving the goal location
-int SingleAgentECBS::extractLastGoalTimestep(int goal_location, const vector< list< pair<int, int> > >* cons) {
+// return the latest timestep (after 0) which has a constraint involving the goal location
+int SingleAgentECBS::extractLastGoalTimestep(int goal_location, const ConstraintTable* cons) {
   if (cons != NULL) {
-    for ( int t = static_cast<int>(cons->size())-1; t > 0; t-- ) {
-      for (list< pair<int, int> >::const_iterator it = cons->at(t).begin(); it != cons->at(t).end(); ++it) {
-        // $$$: in the following if, do we need to check second (maybe cannot happen in edge constraints?)
-        if ((*it).first == goal_location || (*it).second == goal_location) {
-          return (t);
-        }
-      }
-    }
+    int t = cons->getLatestTimestep(goal_location);
+    if (t > 0)
+      return t;
   }
   return -1;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // input: curr_id (location at time next_timestep-1) ; next_id (location at time next_timestep); next_timestep
-//        cons[timestep] is a list of <loc1,loc2> of (vertex/edge) constraints for that timestep.
-inline bool SingleAgentECBS::isConstrained(int curr_loc, int next_loc, int next_timestep, const vector< list< pair<int, int> > >* cons) 
+//        cons holds the (vertex/edge) constraints of the high-level search.
+inline bool SingleAgentECBS::isConstrained(int curr_loc, int next_loc, int next_timestep, const ConstraintTable* cons) 
 {
 	//check whether it is a block
 	if (!my_map[next_loc]) return true;
 
 	//cheack constraints with DELIVER agents
-	for (unsigned int i = 0; i < cons_paths.size(); i++)
-	{
-		if (cons_paths[i][curr_time + next_timestep] == next_loc)
-			return true; //vertext collision
-		else if (cons_paths[i][curr_time + next_timestep] == curr_loc &&cons_paths[i][curr_time + next_timestep - 1] == next_loc)
-			return true; //edge collision
-	}
+	if (cons_paths_table->isConstrained(curr_loc, next_loc, next_timestep))
+		return true;
 
   //  cout << "check if ID="<<id<<" is occupied at TIMESTEP="<<timestep<<endl;
   if (cons == NULL)
     return false;
 
-  // check vertex constraints (being in next_loc at next_timestep is disallowed)
-  if ( next_timestep < static_cast<int>(cons->size()) ) {
-    for ( list< pair<int, int> >::const_iterator it = cons->at(next_timestep).begin(); it != cons->at(next_timestep).end(); ++it ) {
-      if ( (*it).second == -1 ) {
-        if ( (*it).first == next_loc ) {
-          return true;
-        }
-      }
-    }
-  }
-
-  // check edge constraints (the move from curr_id to next_id at next_timestep-1 is disallowed)
-  if ( next_timestep > 0 && next_timestep - 1 < static_cast<int>(cons->size()) ) {
-    for ( list< pair<int, int> >::const_iterator it = cons->at(next_timestep-1).begin(); it != cons->at(next_timestep-1).end(); ++it ) {
-      if ( (*it).first == curr_loc && (*it).second == next_loc ) {
-        return true;
-      }
-    }
-  }
-
-  return false;
+  return cons->isConstrained(curr_loc, next_loc, next_timestep);
 }
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-int SingleAgentECBS::numOfConflictsForStep(int curr_id, int next_id, int next_timestep, bool* res_table, int max_plan_len) {
+int SingleAgentECBS::numOfConflictsForStep(int curr_id, int next_id, int next_timestep, const ReservationTable* res_table, int max_plan_len,
+                                           int exclude_agent) {
   int retVal = 0;
   if (next_timestep >= max_plan_len) {
     // check vertex constraints (being at an agent's goal when he stays there because he is done planning)
-    if ( res_table[next_id + (max_plan_len-1)*map_size] == true )
+    if ( res_table->isReserved(next_id, max_plan_len-1, exclude_agent) )
       retVal++;
     // Note -- there cannot be edge conflicts when other agents are done moving
   } else {
     // check vertex constraints (being in next_id at next_timestep is disallowed)
-    if ( res_table[next_id + next_timestep*map_size] == true )
+    if ( res_table->isReserved(next_id, next_timestep, exclude_agent) )
       retVal++;
     // check edge constraints (the move from curr_id to next_id at next_timestep-1 is disallowed)
     // which means that res_table is occupied with another agent for [curr_id,next_timestep] and [next_id,next_timestep-1]
-    if ( res_table[curr_id + next_timestep*map_size] && res_table[next_id + (next_timestep-1)*map_size] )
+    if ( res_table->isReserved(curr_id, next_timestep, exclude_agent) && res_table->isReserved(next_id, next_timestep-1, exclude_agent) )
       retVal++;
   }
   //  cout << "#CONF=" << retVal << " ; For: curr_id=" << curr_id << " , next_id=" << next_id << " , next_timestep=" << next_timestep
@@ -142,42 +110,75 @@ int SingleAgentECBS::numOfConflictsForStep(int curr_id, int next_id, int next_ti
 }
 
 // $$$ -- is there a more efficient way to do that?
+// only the entries of open_above_focal within the new bound are visited (and removed), not all of OPEN.
+// an entry is stale if its node left OPEN or its f-val decreased since (then a newer entry or FOCAL has it).
 void SingleAgentECBS::updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight) {
   //  cout << "Update Focal: (old_LB=" << old_lower_bound << " ; new_LB=" << new_lower_bound << endl;;
-  for (Node* n : open_list) {
+  std::multimap<double, Node*>::iterator last = open_above_focal.upper_bound(new_lower_bound);
+  for (std::multimap<double, Node*>::iterator it = open_above_focal.begin(); it != last; ++it) {
+    Node* n = it->second;
     //    cout << "   Considering " << n << " , " << *n << endl;
-    if ( n->getFVal() > old_lower_bound &&
-         n->getFVal() <= new_lower_bound ) {
+    if ( n->in_openlist && n->getFVal() == it->first && n->getFVal() > old_lower_bound ) {
       //      cout << "      Added (n->f-val=" << n->getFVal() << ")" << endl;
       n->focal_handle = focal_list.push(n);
     }
   }
+  open_above_focal.erase(open_above_focal.begin(), last);
 }
 
 
 
+bool SingleAgentECBS::reusePath(const vector<int>& old_path, double f_weight) {
+  if (old_path.empty() || old_path[0] != start_location || old_path.back() != goal_location)
+    return false;
+  int plan_len = old_path.size() - 1;
+  if (plan_len > f_weight * my_heuristic[start_location] || plan_len >= max_time - curr_time)
+    return false;
+  for (int t = 1; t <= plan_len; t++) {
+    int step = old_path[t] - old_path[t-1];
+    bool moved = false;
+    for (int direction = 0; direction < 5; direction++)
+      if (step == actions_offset[direction])
+        moved = true;
+    if (!moved || isConstrained(old_path[t-1], old_path[t], t, NULL))
+      return false;
+  }
+  // the goal must be holdable (as in findPath)
+  if (plan_len + curr_time + 1 < max_time && cons_paths_table->getLatestTimestep(goal_location) > plan_len)
+    return false;
+  path = old_path;
+  path_cost = plan_len;
+  min_f_val = my_heuristic[start_location];  // a lower bound on any path's cost
+  num_expanded = 0;
+  num_generated = 0;
+  return true;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // return true if a path found (and updates vector<int> path) or false if no path exists
-bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, int> > >* constraints, bool* res_table, size_t max_plan_len) {
+bool SingleAgentECBS::findPath(double f_weight, const ConstraintTable* constraints, const ReservationTable* res_table, size_t max_plan_len,
+                               int exclude_agent) {
   // clear data structures if they had been used before
   // (note -- nodes are deleted before findPath returns)
   open_list.clear();
   focal_list.clear();
+  open_above_focal.clear();
   //allNodes_table.clear();
-  map<unsigned int, Node*> allNodes_table; //int=g_val*map_size+loc
+  releaseClosedListNodes();
   num_expanded = 0;
   num_generated = 0;
 
   //hashtable_t::iterator it;  // will be used for find()
 
   // generate start and add it to the OPEN list
-  Node* start = new Node(start_location, 0, my_heuristic[start_location], NULL, 0, 0, false);
+  Node* start = node_pool.create(start_location, 0, my_heuristic[start_location], (Node*)NULL, 0, 0, false);
   num_generated++;
   start->open_handle = open_list.push(start);
   start->focal_handle = focal_list.push(start);
   start->in_openlist = true;
   //allNodes_table[start] = start;
-  allNodes_table.insert(make_pair(start_location, start)); //g_val=0
+  allNodes_table[start_location] = start; //g_val=0
   min_f_val = start->getFVal();
   lower_bound = f_weight * min_f_val;
 
@@ -196,22 +197,12 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
     // check if the popped node is a goal
     if (curr->loc == goal_location && curr->timestep > lastGoalConsTime) 
 	{
-		//chack whether it can be held
-		bool hold = true;
-		for (unsigned int ag = 0; ag < cons_paths.size() && hold == true; ag++)
-		{
-			for (unsigned int t = curr->timestep + curr_time + 1; t < cons_paths[ag].size() && hold == true; t++)
-			{
-				if (cons_paths[ag][t] == curr->loc)
-				{
-					hold = false;
-				}
-			}
-		}
+		//chack whether it can be held (no DELIVER agent comes later, up to max_time)
+		bool hold = curr->timestep + curr_time + 1 >= max_time || cons_paths_table->getLatestTimestep(curr->loc) <= curr->timestep;
 		if (hold)
 		{
 			updatePath(curr);
-			releaseClosedListNodes(allNodes_table);
+			releaseClosedListNodes();
 			return true;
 		}
     }
@@ -230,28 +221,30 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 			double next_g_val = curr->g_val + cost;
 			double next_h_val = my_heuristic[next_id];
 			int next_internal_conflicts = 0;
-			if (max_plan_len > 0)  // check if the reservation table is not empty (that is tha max_length of any other agent's plan is > 0)
-				next_internal_conflicts = curr->num_internal_conf + numOfConflictsForStep(curr->loc, next_id, next_timestep, res_table, max_plan_len);
-			// generate (maybe temporary) node
-			Node* next = new Node(next_id, next_g_val, next_h_val, curr, next_timestep, next_internal_conflicts, false);
-			       // cout << "   NEXT(" << next << ")=" << *next << endl;
-			// try to retrieve it from the hash table
-			//it = allNodes_table.find(next);
-			map<unsigned int, Node* >::iterator it = allNodes_table.find(next->loc + next->g_val*my_map.size());
-
-			if (it == allNodes_table.end() && next->g_val<max_time - curr_time) {  // add the newly generated node to open_list and hash table
+			if (res_table != NULL && max_plan_len > 0)  // check if the reservation table is not empty (that is tha max_length of any other agent's plan is > 0)
+				next_internal_conflicts = curr->num_internal_conf + numOfConflictsForStep(curr->loc, next_id, next_timestep, res_table, max_plan_len, exclude_agent);
+			// try to retrieve it from the hash table (a node is only allocated if it is new)
+			int64_t next_key = next_id + (int64_t)next_g_val * map_size;
+			dense_hash_map<int64_t, Node*>::iterator it = allNodes_table.find(next_key);
+
+			if (it == allNodes_table.end()) {  // add the newly generated node to open_list and hash table
+				if (next_g_val >= max_time - curr_time)
+					continue;  // beyond the planning horizon
 				//          cout << "   ADDING it as new." << endl;
+				Node* next = node_pool.create(next_id, next_g_val, next_h_val, curr, next_timestep, next_internal_conflicts, false);
+				       // cout << "   NEXT(" << next << ")=" << *next << endl;
 				next->open_handle = open_list.push(next);
 				next->in_openlist = true;
 				num_generated++;
 				if (next->getFVal() <= lower_bound)
 					next->focal_handle = focal_list.push(next);
+				else
+					open_above_focal.insert(std::make_pair(next->getFVal(), next));
 				//allNodes_table[next] = next;
-				allNodes_table.insert(pair<unsigned int, Node*>(next->loc + next->g_val*my_map.size(), next));
+				allNodes_table[next_key] = next;
 
 			}
 			else {  // update existing node's if needed (only in the open_list)
-				delete(next);  // not needed anymore -- we already generated it before
 				Node* existing_next = (*it).second;
 				//          cout << "Actually next exists. It's address is " << existing_next << endl;
 				if (existing_next->in_openlist == true) {  // if its in the open list
@@ -280,6 +273,8 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 						if (update_open) {
 							open_list.increase(existing_next->open_handle);  // increase because f-val improved
 							//                cout << "     Increased in OPEN" << endl;
+							if (!add_to_focal && !update_in_focal)
+								open_above_focal.insert(std::make_pair(existing_next->getFVal(), existing_next));  // still above the bound
 						}
 						if (add_to_focal) {
 							existing_next->focal_handle = focal_list.push(existing_next);
@@ -309,6 +304,9 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 							existing_next->focal_handle = focal_list.push(existing_next);
 							//                cout << "     Inserted to FOCAL" << endl;
 						}
+						else {
+							open_above_focal.insert(std::make_pair(existing_next->getFVal(), existing_next));
+						}
 					}
 					//            cout << "   Do NOT reopen" << endl;
 				}  // end update a node in closed list
@@ -348,7 +346,7 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
   }  // end while loop
   // no path found
   path.clear();
-  releaseClosedListNodes(allNodes_table);
+  releaseClosedListNodes();
   return false;
 }
 
@@ -6,9 +6,12 @@
 #include <vector>
 #include <list>
 #include <utility>
-#include <sparsehash/dense_hash_map>
+#include <google/dense_hash_map>
 #include <map>
 #include "node.h"
+#include "reservation_table.h"
+#include "constraint_table.h"
+#include "node_pool.h"
 
 using std::cout;
 using google::dense_hash_map;
@@ -46,8 +49,11 @@ class SingleAgentECBS {
 
   //  Node::focal_handle_t focal_handle;
   heap_focal_t focal_list;
+  std::multimap<double, Node*> open_above_focal;  // OPEN nodes above lower_bound, by f-val (some entries may be stale)
 
  // hashtable_t allNodes_table;
+  dense_hash_map<int64_t, Node*> allNodes_table;  // key is loc + g_val*map_size
+  NodePool<Node> node_pool;  // all the nodes of the current search (released in bulk when it ends)
 
   // used in hash table and would be deleted from the d'tor
   //Node* empty_node;
@@ -55,7 +61,7 @@ class SingleAgentECBS {
 
   /* ctor
    */
-  SingleAgentECBS(const vector<vector<int> > &cons_paths, const vector<int> &my_heuristic, const vector<bool> &my_map,
+  SingleAgentECBS(const ConstraintTable* cons_paths_table, const vector<int> &my_heuristic, const vector<bool> &my_map,
 	  int ag_id, int start_location, int goal_location, int col, int curr_time, int max_time);
 
 
@@ -67,15 +73,14 @@ class SingleAgentECBS {
   /* returns the minimal plan length for the agent (that is, extract the latest timestep which
      has a constraint invloving this agent's goal location).
   */
-  int extractLastGoalTimestep(int goal_location, const vector< list< pair<int, int> > >* cons);
+  int extractLastGoalTimestep(int goal_location, const ConstraintTable* cons);
 
-  inline void releaseClosedListNodes(map<unsigned int, Node*> &allNodes_table);
+  inline void releaseClosedListNodes();
 
-  /* Checks if a vaild path found (wrt my_map and constraints)
-     Note -- constraint[timestep] is a list of pairs. Each pair is a disallowed <loc1,loc2> (loc2=-1 for vertex constraint).
+  /* Checks if a vaild path found (wrt my_map, the paths of DELIVER agents and constraints)
      Returns true/false.
   */
-  inline bool isConstrained(int curr_id, int next_id, int next_timestep, const vector< list< pair<int, int> > >* cons);
+  inline bool isConstrained(int curr_id, int next_id, int next_timestep, const ConstraintTable* cons);
 
   /* Updates the path datamember (vector<int>).
      After update it will contain the sequence of locations found from the goal to the start.
@@ -84,17 +89,26 @@ class SingleAgentECBS {
 
   /* Return the number of conflicts between the known_paths' (by looking at the reservation table) for the move [curr_id,next_id].
      Returns 0 if no conflict, 1 for vertex or edge conflict, 2 for both.
+     Note -- the path of exclude_agent in res_table is ignored.
    */
-  int numOfConflictsForStep(int curr_id, int next_id, int next_timestep, bool* res_table, int max_plan_len);
+  int numOfConflictsForStep(int curr_id, int next_id, int next_timestep, const ReservationTable* res_table, int max_plan_len, int exclude_agent);
 
   /* Iterate over OPEN and adds to FOCAL all nodes with: 1) f-val > old_min_f_val ; and 2) f-val * f_weight < new_lower_bound.
    */
   void updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight);
 
+  /* Warm start -- adopts old_path (from start_location at timestep 0) as the search result if it still reaches the goal,
+     satisfies the paths of DELIVER agents and costs at most f_weight times the heuristic (so it is as good as a new search).
+     Returns true/false.
+  */
+  bool reusePath(const vector<int>& old_path, double f_weight);
+
   /* Returns true if a collision free path found (with cost up to f_weight * f-min) while
      minimizing the number of internal conflicts (that is conflicts with known_paths for other agents found so far).
+     A NULL res_table means there are no known paths, so no conflicts are counted.
   */
-  bool findPath(double f_weight, const vector < list< pair<int, int> > >* constraints, bool* res_table, size_t max_plan_len);
+  bool findPath(double f_weight, const ConstraintTable* constraints, const ReservationTable* res_table, size_t max_plan_len,
+                int exclude_agent);
 
   ~SingleAgentECBS();
 private:
@@ -102,8 +116,8 @@ private:
 	int curr_time;
 	int max_time;
 	int actions_offset[5];
-	const vector<vector<int> > cons_paths;
-	const vector<int> my_heuristic;  // this is the precomputed heuristic for this agent
+	const ConstraintTable* cons_paths_table;  // constraints from the paths of DELIVER agents (not owned)
+	const vector<int>& my_heuristic;  // this is the precomputed heuristic for this agent (the goal's, not copied)
 };
 
 #endif